@@ -0,0 +1,303 @@
+//
+// Benchmarks of the expression evaluation passes
+// Author: Max Benson
+// Date: 12/13/2021
+//
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+using std::endl;
+using std::getline;
+using std::string;
+
+#include "Benchmark.h"
+#include "ExpressionProgram.h"
+#include "ExpressionTree.h"
+
+/**
+ * Time repeated evaluation of a compiled program.  The variable values are
+ * changed on every iteration so that nothing can be hoisted out of the loop.
+ * Each value depends on the variable's name rather than its position, so
+ * programs that number their variables differently still get the same values.
+ * @param program compiled expression
+ * @param iterations number of evaluations
+ * @param checksum receives the sum of all results
+ * @return average nanoseconds per evaluation
+ */
+static double TimeEvaluation(ExpressionProgram& program, size_t iterations, unsigned& checksum) {
+    std::vector<int> values(program.VariableCount() + 1);
+    std::vector<size_t> offsets(values.size(), 0);
+
+    for (size_t v = 0; v < program.VariableCount(); v ++) {
+        offsets[v] = std::hash<string>()(program.VariableName(v));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    checksum = 0;
+    for (size_t i = 0; i < iterations; i ++) {
+        for (size_t v = 0; v < values.size(); v ++) {
+            values[v] = (int) (i + 3*offsets[v] + 1);
+        }
+        checksum += (unsigned) program.Evaluate(values.data());
+    }
+
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return iterations > 0 ? elapsed.count() / iterations : 0;
+}
+
+/**
+ * For each postfix expression read, compare tree depth and evaluation time
+ * of the simplified tree before and after Rebalance
+ * @param is stream of postfix expressions, one per line
+ * @param os receives one report line per expression
+ * @param iterations number of evaluations timed for each form
+ * @return exit status
+ */
+int RunRebalanceBenchmark(istream& is, ostream& os, size_t iterations) {
+    string postfix;
+
+    while (getline(is, postfix)) {
+        if (postfix.length() == 0 || postfix[0] == '#') {
+            continue;
+        }
+
+        ExpressionTree expTree;
+        ExpressionProgram program;
+        unsigned before;
+        unsigned after;
+
+        if (!expTree.BuildExpressionTree(postfix)) {
+            continue;
+        }
+        expTree.Simplify();
+
+        size_t depthBefore = expTree.Depth();
+        program.Compile(expTree.Root());
+        double nsBefore = TimeEvaluation(program, iterations, before);
+
+        expTree.Rebalance();
+        size_t depthAfter = expTree.Depth();
+        program.Compile(expTree.Root());
+        double nsAfter = TimeEvaluation(program, iterations, after);
+
+        os << "depth " << depthBefore << " -> " << depthAfter
+           << ", ns/eval " << nsBefore << " -> " << nsAfter
+           << (before == after ? ", results match" : ", RESULTS DIFFER") << endl;
+    }
+    return 0;
+}
+
+/**
+ * Count the operators of a tree by kind, without recursion
+ * @param tree expression tree
+ * @param additions receives the number of + and - operators
+ * @param multiplications receives the number of * and / operators
+ * @param powers receives the number of ^ operators
+ */
+static void CountOperations(const TreeNode* tree, size_t& additions, size_t& multiplications, size_t& powers) {
+    std::vector<const TreeNode*> pending(1, tree);
+
+    additions = multiplications = powers = 0;
+    while (!pending.empty()) {
+        const TreeNode* node = pending.back();
+        pending.pop_back();
+
+        if (node->Type() == Operator) {
+            char op = node->Data()[0];
+            if (op == '+' || op == '-') {
+                additions++;
+            } else if (op == '^') {
+                powers++;
+            } else {
+                multiplications++;
+            }
+            pending.push_back(node->Left());
+            pending.push_back(node->Right());
+        }
+    }
+}
+
+/**
+ * For each postfix expression read, compare operation counts and evaluation
+ * time of the simplified tree before and after rewriting it in Horner form
+ * @param is stream of postfix expressions, one per line
+ * @param os receives one report line per expression
+ * @param iterations number of evaluations timed for each form
+ * @return exit status
+ */
+int RunHornerBenchmark(istream& is, ostream& os, size_t iterations) {
+    string postfix;
+
+    while (getline(is, postfix)) {
+        if (postfix.length() == 0 || postfix[0] == '#') {
+            continue;
+        }
+
+        ExpressionTree expTree;
+        ExpressionProgram program;
+        size_t additions[2];
+        size_t multiplications[2];
+        size_t powers[2];
+        unsigned before;
+        unsigned after;
+
+        expTree.SetSimplifyOnBuild(true);
+        if (!expTree.BuildExpressionTree(postfix)) {
+            continue;
+        }
+
+        CountOperations(expTree.Root(), additions[0], multiplications[0], powers[0]);
+        program.Compile(expTree.Root());
+        double nsBefore = TimeEvaluation(program, iterations, before);
+
+        expTree.Horner();
+        CountOperations(expTree.Root(), additions[1], multiplications[1], powers[1]);
+        program.Compile(expTree.Root());
+        double nsAfter = TimeEvaluation(program, iterations, after);
+
+        os << "+- " << additions[0] << " -> " << additions[1]
+           << ", */ " << multiplications[0] << " -> " << multiplications[1]
+           << ", ^ " << powers[0] << " -> " << powers[1]
+           << ", ns/eval " << nsBefore << " -> " << nsAfter
+           << (before == after ? ", results match" : ", RESULTS DIFFER") << endl;
+    }
+    return 0;
+}
+
+/**
+ * For each postfix expression read, compare tree size and evaluation time
+ * of the tree as built and after Simplify.  Meant for product heavy input,
+ * where simplifying combines repeated factors into powers.
+ * @param is stream of postfix expressions, one per line
+ * @param os receives one report line per expression
+ * @param iterations number of evaluations timed for each form
+ * @return exit status
+ */
+int RunPowerBenchmark(istream& is, ostream& os, size_t iterations) {
+    string postfix;
+
+    while (getline(is, postfix)) {
+        if (postfix.length() == 0 || postfix[0] == '#') {
+            continue;
+        }
+
+        ExpressionTree expTree;
+        ExpressionProgram program;
+        unsigned before;
+        unsigned after;
+
+        if (!expTree.BuildExpressionTree(postfix)) {
+            continue;
+        }
+
+        size_t sizeBefore = expTree.Size();
+        program.Compile(expTree.Root());
+        size_t instructionsBefore = program.InstructionCount();
+        double nsBefore = TimeEvaluation(program, iterations, before);
+
+        expTree.Simplify();
+        size_t sizeAfter = expTree.Size();
+        program.Compile(expTree.Root());
+        size_t instructionsAfter = program.InstructionCount();
+        double nsAfter = TimeEvaluation(program, iterations, after);
+
+        os << "nodes " << sizeBefore << " -> " << sizeAfter
+           << ", instructions " << instructionsBefore << " -> " << instructionsAfter
+           << ", ns/eval " << nsBefore << " -> " << nsAfter
+           << (before == after ? ", results match" : ", RESULTS DIFFER") << endl;
+    }
+    return 0;
+}
+
+/**
+ * Read a set of postfix expressions and compare evaluating them one program
+ * per tree against one fused program sharing common subexpressions.  Both
+ * are fed the same values for each variable on every iteration.  Invalid
+ * lines are skipped without a message.
+ * @param is stream of postfix expressions, one per line
+ * @param os receives the report
+ * @param iterations number of rows evaluated
+ * @return exit status
+ */
+int RunFusedBenchmark(istream& is, ostream& os, size_t iterations) {
+    std::vector<ExpressionTree> trees;
+    std::vector<const TreeNode*> roots;
+    string postfix;
+
+    while (getline(is, postfix)) {
+        if (postfix.length() == 0 || postfix[0] == '#') {
+            continue;
+        }
+
+        ExpressionTree expTree;
+        expTree.SetSimplifyOnBuild(true);
+        expTree.SetReportErrors(false);
+        if (expTree.BuildExpressionTree(postfix)) {
+            trees.push_back(expTree);
+        }
+    }
+    if (trees.empty()) {
+        return 0;
+    }
+    for (size_t i = 0; i < trees.size(); i ++) {
+        roots.push_back(trees[i].Root());
+    }
+
+    ExpressionProgram fused;
+    fused.Compile(roots);
+
+    // Each separate program numbers its variables itself, map them to the fused numbering
+    std::vector<ExpressionProgram> separate(trees.size());
+    std::vector<std::vector<size_t> > variableMap(trees.size());
+    size_t separateInstructions = 0;
+    for (size_t t = 0; t < trees.size(); t ++) {
+        separate[t].Compile(roots[t]);
+        separateInstructions += separate[t].InstructionCount();
+        for (size_t v = 0; v < separate[t].VariableCount(); v ++) {
+            variableMap[t].push_back(fused.VariableIndex(separate[t].VariableName(v)));
+        }
+    }
+
+    std::vector<int> values(fused.VariableCount() + 1);
+    std::vector<int> results(trees.size());
+    std::vector<int> treeValues(values.size());
+    unsigned separateChecksum = 0;
+    unsigned fusedChecksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i ++) {
+        for (size_t v = 0; v < values.size(); v ++) {
+            values[v] = (int) (i + 3*v + 1);
+        }
+        for (size_t t = 0; t < trees.size(); t ++) {
+            for (size_t v = 0; v < variableMap[t].size(); v ++) {
+                treeValues[v] = values[variableMap[t][v]];
+            }
+            separateChecksum += (unsigned) separate[t].Evaluate(treeValues.data()) * (unsigned) (t + 1);
+        }
+    }
+    std::chrono::duration<double, std::nano> separateTime = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i ++) {
+        for (size_t v = 0; v < values.size(); v ++) {
+            values[v] = (int) (i + 3*v + 1);
+        }
+        fused.Evaluate(values.data(), results.data());
+        for (size_t t = 0; t < trees.size(); t ++) {
+            fusedChecksum += (unsigned) results[t] * (unsigned) (t + 1);
+        }
+    }
+    std::chrono::duration<double, std::nano> fusedTime = std::chrono::steady_clock::now() - start;
+
+    os << trees.size() << " expressions, " << fused.VariableCount() << " variables" << endl;
+    os << "separate: " << separateInstructions << " instructions, "
+       << separateTime.count() / iterations << " ns/row" << endl;
+    os << "fused:    " << fused.InstructionCount() << " instructions, "
+       << fusedTime.count() / iterations << " ns/row" << endl;
+    os << (separateChecksum == fusedChecksum ? "results match" : "RESULTS DIFFER") << endl;
+    return 0;
+}
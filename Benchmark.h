@@ -0,0 +1,18 @@
+//
+// Benchmarks of the expression evaluation passes
+// Author: Max Benson
+// Date: 12/13/2021
+//
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <iostream>
+using std::istream;
+using std::ostream;
+
+int RunRebalanceBenchmark(istream& is, ostream& os, size_t iterations);
+int RunFusedBenchmark(istream& is, ostream& os, size_t iterations);
+int RunPowerBenchmark(istream& is, ostream& os, size_t iterations);
+int RunHornerBenchmark(istream& is, ostream& os, size_t iterations);
+
+#endif //BENCHMARK_H
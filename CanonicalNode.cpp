@@ -0,0 +1,178 @@
+//
+// Implements the CanonicalNode Class
+// Author: Max Benson
+// Date: 11/22/2021
+//
+
+#include <stdlib.h>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include "CanonicalNode.h"
+
+/**
+ * Mixes a value into a running hash
+ * @param seed hash so far
+ * @param value value to mix in
+ * @return new hash
+ */
+static size_t HashCombine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * Constructor
+ * @param kind kind of node
+ * @param data number, variable name, or operator
+ */
+CanonicalNode::CanonicalNode(CanonicalKind kind, const string& data) {
+    _kind = kind;
+    _data = data;
+    _negated = false;
+    _hash = 0;
+}
+
+/**
+ * Destructor
+ * Frees the operands
+ */
+CanonicalNode::~CanonicalNode() {
+    for (size_t i = 0; i < _operands.size(); i ++) {
+        delete _operands[i];
+    }
+}
+
+/**
+ * Build the canonical form of an expression tree
+ * @param tree expression tree, not modified
+ * @return newly allocated canonical node, caller must delete it
+ */
+CanonicalNode* CanonicalNode::Build(const TreeNode* tree) {
+    CanonicalNode* node;
+
+    if (tree->Type() == NumberOperand) {
+        node = new CanonicalNode(CanonicalNumber, tree->Data());
+    } else if (tree->Type() == VariableOperand) {
+        node = new CanonicalNode(CanonicalVariable, tree->Data());
+    } else if (tree->Data() == "+" || tree->Data() == "-") {
+        return BuildChain(tree, CanonicalSum);
+    } else if (tree->Data() == "*") {
+        return BuildChain(tree, CanonicalProduct);
+    } else {
+        // Operators that are neither associative nor commutative keep their operand order
+        node = new CanonicalNode(CanonicalOperator, tree->Data());
+        node->_operands.push_back(Build(tree->Left()));
+        node->_operands.push_back(Build(tree->Right()));
+    }
+    node->Finish();
+    return node;
+}
+
+/**
+ * Flatten a chain of + and - (kind CanonicalSum) or of * (kind CanonicalProduct)
+ * into a single n-ary node.  The chain is walked with an explicit stack so
+ * long chains do not cost recursion depth.  The numbers in the chain are
+ * folded into one operand, wrapping like ExpressionProgram, and dropped
+ * when it is 0 in a sum or 1 in a product, so (x+2)+3 and x+5 have the same
+ * canonical form even though Simplify leaves the first as it is.  In a sum
+ * the variable -x counts as x subtracted.
+ * @param tree root of the chain
+ * @param kind CanonicalSum or CanonicalProduct
+ * @return newly allocated canonical node
+ */
+CanonicalNode* CanonicalNode::BuildChain(const TreeNode* tree, CanonicalKind kind) {
+    CanonicalNode* node = new CanonicalNode(kind, kind == CanonicalSum ? "+" : "*");
+    std::vector<std::pair<const TreeNode*, bool> > pending;
+    uint32_t constant = kind == CanonicalSum ? 0 : 1;
+
+    pending.push_back(std::make_pair(tree, false));
+    while (!pending.empty()) {
+        const TreeNode* term = pending.back().first;
+        bool negated = pending.back().second;
+        pending.pop_back();
+
+        if (term->Type() == Operator && kind == CanonicalSum && (term->Data() == "+" || term->Data() == "-")) {
+            pending.push_back(std::make_pair(term->Right(), term->Data() == "-" ? !negated : negated));
+            pending.push_back(std::make_pair(term->Left(), negated));
+        } else if (term->Type() == Operator && kind == CanonicalProduct && term->Data() == "*") {
+            pending.push_back(std::make_pair(term->Right(), false));
+            pending.push_back(std::make_pair(term->Left(), false));
+        } else if (term->IsNumber()) {
+            uint32_t value = (uint32_t) atoi(term->Data().c_str());
+
+            if (kind == CanonicalProduct) {
+                constant *= value;
+            } else {
+                constant += negated ? 0 - value : value;
+            }
+        } else if (kind == CanonicalSum && term->Type() == VariableOperand && term->Data()[0] == '-') {
+            CanonicalNode* operand = new CanonicalNode(CanonicalVariable, term->Data().substr(1));
+            operand->_negated = !negated;
+            operand->Finish();
+            node->_operands.push_back(operand);
+        } else {
+            CanonicalNode* operand = Build(term);
+            operand->_negated = negated;
+            node->_operands.push_back(operand);
+        }
+    }
+    if (constant != (kind == CanonicalSum ? 0u : 1u)) {
+        CanonicalNode* operand = new CanonicalNode(CanonicalNumber, to_string((int32_t) constant));
+        operand->Finish();
+        node->_operands.push_back(operand);
+    }
+    node->Finish();
+    return node;
+}
+
+/**
+ * Sort the operands into canonical order and compute the hash of the node.
+ * Operands must already be finished.
+ */
+void CanonicalNode::Finish() {
+    if (_kind == CanonicalSum || _kind == CanonicalProduct) {
+        std::sort(_operands.begin(), _operands.end(), [](const CanonicalNode* node1, const CanonicalNode* node2) {
+            return Compare(node1, node2) < 0;
+        });
+    }
+    _hash = HashCombine(std::hash<string>()(_data), _kind);
+    for (size_t i = 0; i < _operands.size(); i ++) {
+        _hash = HashCombine(_hash, HashCombine(_operands[i]->_hash, _operands[i]->_negated));
+    }
+}
+
+/**
+ * Total order on canonical nodes.  Hashes are compared before contents so
+ * that unequal expressions are usually told apart in O(1).
+ * @param node1 first node
+ * @param node2 second node
+ * @return negative, zero, or positive as node1 orders before, same as, or after node2
+ */
+int CanonicalNode::Compare(const CanonicalNode* node1, const CanonicalNode* node2) {
+    if (node1 == node2) {
+        return 0;
+    }
+    if (node1->_kind != node2->_kind) {
+        return node1->_kind < node2->_kind ? -1 : 1;
+    }
+    if (node1->_hash != node2->_hash) {
+        return node1->_hash < node2->_hash ? -1 : 1;
+    }
+    if (node1->_negated != node2->_negated) {
+        return node1->_negated ? 1 : -1;
+    }
+    int compare = node1->_data.compare(node2->_data);
+    if (compare != 0) {
+        return compare;
+    }
+    if (node1->_operands.size() != node2->_operands.size()) {
+        return node1->_operands.size() < node2->_operands.size() ? -1 : 1;
+    }
+    for (size_t i = 0; i < node1->_operands.size(); i ++) {
+        compare = Compare(node1->_operands[i], node2->_operands[i]);
+        if (compare != 0) {
+            return compare;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+//
+// Interface Definition for the CanonicalNode Class
+// Author: Max Benson
+// Date: 11/22/2021
+//
+// A CanonicalNode is an n-ary view of an expression used for comparing
+// expressions.  Chains of + and - are flattened into a single Sum whose
+// operands carry a sign, chains of * into a single Product, and the operands
+// of both are sorted into a canonical order.  As a result x+y and y+x, or
+// (a*b)*c and a*(c*b), produce identical canonical nodes.
+//
+#ifndef CANONICALNODE_H
+#define CANONICALNODE_H
+
+#include <vector>
+#include "TreeNode.h"
+
+enum CanonicalKind {
+    CanonicalNumber,
+    CanonicalVariable,
+    CanonicalSum,
+    CanonicalProduct,
+    CanonicalOperator
+};
+
+class CanonicalNode {
+public:
+    static CanonicalNode* Build(const TreeNode* tree);
+    ~CanonicalNode();
+
+    CanonicalKind Kind() const { return _kind; };
+    const string& Data() const { return _data; };
+    bool IsNegated() const { return _negated; };
+    size_t Hash() const { return _hash; };
+    size_t OperandCount() const { return _operands.size(); };
+    const CanonicalNode* Operand(size_t i) const { return _operands[i]; };
+
+    static int Compare(const CanonicalNode* node1, const CanonicalNode* node2);
+    static bool IsSame(const CanonicalNode* node1, const CanonicalNode* node2) { return Compare(node1, node2) == 0; };
+
+private:
+    CanonicalNode(CanonicalKind kind, const string& data);
+
+    static CanonicalNode* BuildChain(const TreeNode* tree, CanonicalKind kind);
+    void Finish();
+
+    CanonicalKind _kind;
+    string _data;
+    bool _negated;
+    size_t _hash;
+    std::vector<CanonicalNode*> _operands;
+};
+
+#endif //CANONICALNODE_H
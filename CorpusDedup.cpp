@@ -0,0 +1,120 @@
+//
+// Grouping of equivalent expressions in a large corpus
+// Author: Max Benson
+// Date: 01/17/2022
+//
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using std::cerr;
+using std::endl;
+using std::getline;
+using std::string;
+
+#include "CorpusDedup.h"
+#include "ExpressionTree.h"
+#include "InternTable.h"
+
+/**
+ * Read postfix expressions, one per line, and write them grouped by
+ * equivalence.  Expressions are grouped by fingerprint, so expressions that
+ * are equal as polynomials end up together even when their trees differ.
+ * With fConfirm each group is split further into classes whose members
+ * expand to the same polynomial.  Expanded coefficients wrap modulo 2^32,
+ * so members are confirmed equal when their coefficients agree modulo
+ * 2^32: they always compute the same wrapped results, but a fingerprint
+ * collision between polynomials that differ only by multiples of 2^32 is
+ * not split.  Equal polynomials expand to identical trees, so expanded
+ * members are classed by StructureId in one lookup each; only members
+ * whose expansion passed a bound are kept as trees and compared with
+ * IsSameExpression.
+ * Each group is written as a comment line giving its size, followed by its
+ * members in input order.  Invalid lines are left out of the groups and
+ * counted on standard error.
+ * @param is stream of postfix expressions
+ * @param os receives the groups
+ * @param fConfirm whether to confirm groups by comparing expanded forms
+ * @return exit status
+ */
+int RunCorpusDedup(istream& is, ostream& os, bool fConfirm) {
+    std::vector<string> lines;
+    std::vector<ExpressionTree> trees;
+    std::vector<uint32_t> expandedIds;
+    std::unordered_map<ExpressionFingerprint, size_t, ExpressionFingerprintHash> groupOf;
+    std::vector<std::vector<size_t> > groups;
+    string postfix;
+    size_t skipped = 0;
+
+    while (getline(is, postfix)) {
+        if (postfix.length() == 0 || postfix[0] == '#') {
+            continue;
+        }
+
+        ExpressionTree expTree;
+        expTree.SetSimplifyOnBuild(true);
+        expTree.SetReportErrors(false);
+        if (!expTree.BuildExpressionTree(postfix)) {
+            skipped ++;
+            continue;
+        }
+
+        ExpressionFingerprint fingerprint = expTree.Fingerprint();
+        std::unordered_map<ExpressionFingerprint, size_t, ExpressionFingerprintHash>::iterator found = groupOf.find(fingerprint);
+        if (found == groupOf.end()) {
+            found = groupOf.emplace(fingerprint, groups.size()).first;
+            groups.push_back(std::vector<size_t>());
+        }
+        groups[found->second].push_back(lines.size());
+        lines.push_back(postfix);
+        if (fConfirm) {
+            if (expTree.Expand()) {
+                expandedIds.push_back(expTree.StructureId());
+                trees.push_back(ExpressionTree());
+            } else {
+                expandedIds.push_back(NoInternId);
+                trees.push_back(expTree);
+            }
+        }
+    }
+
+    if (skipped > 0) {
+        cerr << "Skipped " << skipped << " invalid expression" << (skipped == 1 ? "" : "s") << endl;
+    }
+
+    size_t count = 0;
+    for (size_t g = 0; g < groups.size(); g ++) {
+        std::vector<std::vector<size_t> > classes;
+
+        if (fConfirm) {
+            std::unordered_map<uint32_t, size_t> classOf;
+
+            for (size_t i = 0; i < groups[g].size(); i ++) {
+                size_t member = groups[g][i];
+                size_t c = 0;
+                if (expandedIds[member] != NoInternId) {
+                    c = classOf.emplace(expandedIds[member], classes.size()).first->second;
+                } else {
+                    while (c < classes.size() && (expandedIds[classes[c][0]] != NoInternId || !trees[classes[c][0]].IsSameExpression(trees[member]))) {
+                        c++;
+                    }
+                }
+                if (c == classes.size()) {
+                    classes.push_back(std::vector<size_t>());
+                }
+                classes[c].push_back(member);
+            }
+        } else {
+            classes.push_back(groups[g]);
+        }
+
+        for (size_t c = 0; c < classes.size(); c ++) {
+            os << "# group " << ++count << ": " << classes[c].size() << " expression" << (classes[c].size() == 1 ? "" : "s") << endl;
+            for (size_t i = 0; i < classes[c].size(); i ++) {
+                os << lines[classes[c][i]] << endl;
+            }
+        }
+    }
+    return 0;
+}
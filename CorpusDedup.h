@@ -0,0 +1,15 @@
+//
+// Grouping of equivalent expressions in a large corpus
+// Author: Max Benson
+// Date: 01/17/2022
+//
+#ifndef CORPUSDEDUP_H
+#define CORPUSDEDUP_H
+
+#include <iostream>
+using std::istream;
+using std::ostream;
+
+int RunCorpusDedup(istream& is, ostream& os, bool fConfirm);
+
+#endif //CORPUSDEDUP_H
@@ -0,0 +1,258 @@
+//
+// Implements the ExpressionProgram Class
+// Author: Max Benson
+// Date: 12/13/2021
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include "WrappedArithmetic.h"
+#include "ExpressionProgram.h"
+
+// While compiling, operands are tagged with the kind of slot they refer to.
+// Slot numbers are fixed up once the number of variables and constants is known.
+static const uint32_t VariableTag = 0u << 30;
+static const uint32_t ConstantTag = 1u << 30;
+static const uint32_t TemporaryTag = 2u << 30;
+static const uint32_t TagMask = 3u << 30;
+
+/**
+ * Default constructor
+ * Creates an empty program
+ */
+ExpressionProgram::ExpressionProgram() {
+}
+
+/**
+ * Compile a single expression tree, replacing anything compiled before.
+ * Variables are numbered in the order they are first met in a left to right walk.
+ * @param tree expression tree, not modified
+ */
+void ExpressionProgram::Compile(const TreeNode* tree) {
+    Compile(std::vector<const TreeNode*>(1, tree));
+}
+
+/**
+ * Compile a set of expression trees into one program with one output per
+ * tree, replacing anything compiled before.  Variables are numbered in the
+ * order they are first met, walking the trees in order from left to right.
+ * @param trees expression trees, not modified
+ */
+void ExpressionProgram::Compile(const std::vector<const TreeNode*>& trees) {
+    struct Frame {
+        const TreeNode* node;
+        bool fExpanded;
+    };
+    std::vector<Frame> pending;
+    std::vector<uint32_t> operands;
+
+    _variables.clear();
+    _variableIndex.clear();
+    _constants.clear();
+    _constantIndex.clear();
+    _instructions.clear();
+    _valueNumbers.clear();
+    _outputs.clear();
+
+    for (size_t t = 0; t < trees.size(); t ++) {
+        // Postorder walk with an explicit stack so long chains do not recurse
+        pending.push_back({trees[t], false});
+        while (!pending.empty()) {
+            Frame frame = pending.back();
+            const TreeNode* node = frame.node;
+            pending.pop_back();
+
+            if (node->Type() == NumberOperand) {
+                operands.push_back(ConstantSlot(atoi(node->Data().c_str())));
+            } else if (node->Type() == VariableOperand) {
+                const string& name = node->Data();
+                if (name.length() > 1 && name[0] == '-') {
+                    // Negated variable produced by simplification of 0 - x
+                    operands.push_back(AddInstruction('-', ConstantSlot(0), VariableSlot(name.substr(1))));
+                } else {
+                    operands.push_back(VariableSlot(name));
+                }
+            } else if (!frame.fExpanded) {
+                pending.push_back({node, true});
+                pending.push_back({node->Right(), false});
+                pending.push_back({node->Left(), false});
+            } else {
+                uint32_t right = operands.back();
+                operands.pop_back();
+                uint32_t left = operands.back();
+                operands.pop_back();
+                operands.push_back(AddInstruction(node->Data()[0], left, right));
+            }
+        }
+        assert(operands.size() == 1);
+        _outputs.push_back(operands.back());
+        operands.pop_back();
+    }
+    _valueNumbers.clear();
+
+    // Lay out slots as variables, constants, temporaries
+    uint32_t constantBase = _variables.size();
+    uint32_t temporaryBase = constantBase + _constants.size();
+    auto fixup = [constantBase, temporaryBase](uint32_t operand) -> uint32_t {
+        switch (operand & TagMask) {
+            case ConstantTag:
+                return constantBase + (operand & ~TagMask);
+            case TemporaryTag:
+                return temporaryBase + (operand & ~TagMask);
+            default:
+                return operand & ~TagMask;
+        }
+    };
+    for (size_t i = 0; i < _instructions.size(); i ++) {
+        _instructions[i].left = fixup(_instructions[i].left);
+        _instructions[i].right = fixup(_instructions[i].right);
+        _instructions[i].result = fixup(_instructions[i].result);
+    }
+    for (size_t i = 0; i < _outputs.size(); i ++) {
+        _outputs[i] = fixup(_outputs[i]);
+    }
+
+    _slots.assign(temporaryBase + _instructions.size(), 0);
+    for (size_t i = 0; i < _constants.size(); i ++) {
+        _slots[constantBase + i] = (uint32_t) _constants[i];
+    }
+}
+
+/**
+ * Find the position of a variable in the values passed to Evaluate
+ * @param name variable name
+ * @return position, or -1 if the expression does not use the variable
+ */
+int ExpressionProgram::VariableIndex(const string& name) const {
+    std::unordered_map<string, uint32_t>::const_iterator found = _variableIndex.find(name);
+
+    return found == _variableIndex.end() ? -1 : (int) found->second;
+}
+
+/**
+ * Evaluate the first compiled expression
+ * @param values one value per variable, in the order given by VariableName
+ * @return value of the expression
+ */
+int ExpressionProgram::Evaluate(const int* values) {
+    Run(values);
+    return (int) _slots[_outputs[0]];
+}
+
+/**
+ * Evaluate all the compiled expressions
+ * @param values one value per variable, in the order given by VariableName
+ * @param results receives one value per compiled tree, in the order compiled
+ */
+void ExpressionProgram::Evaluate(const int* values, int* results) {
+    Run(values);
+    for (size_t i = 0; i < _outputs.size(); i ++) {
+        results[i] = (int) _slots[_outputs[i]];
+    }
+}
+
+/**
+ * Execute the instructions, leaving the results in the slots
+ * @param values one value per variable
+ */
+void ExpressionProgram::Run(const int* values) {
+    uint32_t* slots = _slots.data();
+
+    for (size_t i = 0; i < _variables.size(); i ++) {
+        slots[i] = (uint32_t) values[i];
+    }
+    for (const Instruction& instruction : _instructions) {
+        uint32_t left = slots[instruction.left];
+        uint32_t right = slots[instruction.right];
+
+        switch (instruction.op) {
+            case '+':
+                slots[instruction.result] = left + right;
+                break;
+            case '-':
+                slots[instruction.result] = left - right;
+                break;
+            case '/':
+                slots[instruction.result] = WrappedDivide(left, right);
+                break;
+            case '^':
+                slots[instruction.result] = WrappedPower(left, right);
+                break;
+            default:
+                slots[instruction.result] = left * right;
+                break;
+        }
+    }
+}
+
+/**
+ * Tagged slot of a variable, adding it if it's new
+ * @param name variable name
+ * @return tagged slot
+ */
+uint32_t ExpressionProgram::VariableSlot(const string& name) {
+    int index = VariableIndex(name);
+
+    if (index < 0) {
+        index = _variables.size();
+        _variables.push_back(name);
+        _variableIndex.emplace(name, index);
+    }
+    return VariableTag | (uint32_t) index;
+}
+
+/**
+ * Tagged slot of a constant, adding it if it's new
+ * @param value constant
+ * @return tagged slot
+ */
+uint32_t ExpressionProgram::ConstantSlot(int value) {
+    std::unordered_map<int, uint32_t>::const_iterator found = _constantIndex.find(value);
+
+    if (found != _constantIndex.end()) {
+        return ConstantTag | found->second;
+    }
+    _constantIndex.emplace(value, _constants.size());
+    _constants.push_back(value);
+    return ConstantTag | (uint32_t) (_constants.size() - 1);
+}
+
+/**
+ * Tagged slot holding left op right, adding an instruction only if the
+ * same computation has not been compiled already
+ * @param op operator
+ * @param left tagged slot of the left operand
+ * @param right tagged slot of the right operand
+ * @return tagged slot of the result
+ */
+uint32_t ExpressionProgram::AddInstruction(char op, uint32_t left, uint32_t right) {
+    if ((op == '+' || op == '*') && right < left) {
+        uint32_t swap = left;
+        left = right;
+        right = swap;
+    }
+
+    InstructionKey key = {op, left, right};
+    std::unordered_map<InstructionKey, uint32_t, InstructionKeyHash>::const_iterator found = _valueNumbers.find(key);
+    if (found != _valueNumbers.end()) {
+        return found->second;
+    }
+
+    Instruction instruction = {op, left, right, TemporaryTag | (uint32_t) _instructions.size()};
+    _instructions.push_back(instruction);
+    _valueNumbers.emplace(key, instruction.result);
+    return instruction.result;
+}
+
+/**
+ * Hash of an instruction key
+ * @param key key to hash
+ * @return hash value
+ */
+size_t ExpressionProgram::InstructionKeyHash::operator()(const InstructionKey& key) const {
+    uint64_t h = (uint64_t) key.op;
+
+    h = h * 0x9E3779B97F4A7C15ULL + key.left;
+    h = h * 0x9E3779B97F4A7C15ULL + key.right;
+    return (size_t) (h ^ (h >> 29));
+}
@@ -0,0 +1,82 @@
+//
+// Interface Definition for the ExpressionProgram Class
+// Author: Max Benson
+// Date: 12/13/2021
+//
+// One or more expression trees compiled into a flat list of three address
+// instructions over an array of integer slots.  Slots hold, in order, the
+// variables, the constants, and one temporary per instruction.  Evaluation
+// is a single loop with no recursion or string lookups, so independent
+// instructions can overlap in the processor.
+//
+// When several trees are compiled together they share variables and, by
+// value numbering, every common subexpression: a subtree such as x*y that
+// occurs in many of the trees (or several times in one) is computed once.
+// Operands of + and * are put in a fixed order first, so y*x is recognized
+// as x*y.  Each tree gets its own output.
+//
+// Arithmetic wraps modulo 2^32 the way unsigned arithmetic does, which keeps
+// + and * associative so trees may be regrouped without changing results.
+// / and ^ are defined in WrappedArithmetic.h.
+//
+#ifndef EXPRESSIONPROGRAM_H
+#define EXPRESSIONPROGRAM_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "TreeNode.h"
+
+class ExpressionProgram {
+public:
+    ExpressionProgram();
+
+    void Compile(const TreeNode* tree);
+    void Compile(const std::vector<const TreeNode*>& trees);
+
+    size_t VariableCount() const { return _variables.size(); };
+    const string& VariableName(size_t i) const { return _variables[i]; };
+    int VariableIndex(const string& name) const;
+    size_t InstructionCount() const { return _instructions.size(); };
+    size_t OutputCount() const { return _outputs.size(); };
+
+    int Evaluate(const int* values);
+    void Evaluate(const int* values, int* results);
+
+private:
+    struct Instruction {
+        char op;
+        uint32_t left;
+        uint32_t right;
+        uint32_t result;
+    };
+
+    struct InstructionKey {
+        char op;
+        uint32_t left;
+        uint32_t right;
+
+        bool operator==(const InstructionKey& other) const {
+            return op == other.op && left == other.left && right == other.right;
+        }
+    };
+    struct InstructionKeyHash {
+        size_t operator()(const InstructionKey& key) const;
+    };
+
+    uint32_t VariableSlot(const string& name);
+    uint32_t ConstantSlot(int value);
+    uint32_t AddInstruction(char op, uint32_t left, uint32_t right);
+    void Run(const int* values);
+
+    std::vector<string> _variables;
+    std::unordered_map<string, uint32_t> _variableIndex;
+    std::vector<int> _constants;
+    std::unordered_map<int, uint32_t> _constantIndex;
+    std::vector<Instruction> _instructions;
+    std::unordered_map<InstructionKey, uint32_t, InstructionKeyHash> _valueNumbers;
+    std::vector<uint32_t> _slots;
+    std::vector<uint32_t> _outputs;
+};
+
+#endif //EXPRESSIONPROGRAM_H
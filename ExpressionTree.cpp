@@ -4,14 +4,23 @@
 // Date: 10/27/2021
 //
 
+#include <ctype.h>
+#include <stdlib.h>
 #include <iostream>
 #include <sstream>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 using std::cout;
 using std::endl;
 using std::string;
 using std::stringstream;
 
+#include "CanonicalNode.h"
+#include "InternTable.h"
+#include "Polynomial.h"
 #include "Stack.h"
+#include "WrappedArithmetic.h"
 #include "ExpressionTree.h"
 
 // Token testing routines
@@ -21,10 +30,13 @@ bool IsOperator(string token);
 
 /**
  * Default constructor
- * Creates an "null tree"
+ * Creates an "null tree" with no limit on its depth
  */
 ExpressionTree::ExpressionTree() {
     _root=nullptr;
+    _maxDepth=0;
+    _fSimplifyOnBuild=false;
+    _fReportErrors=true;
 }
 
 /**
@@ -32,23 +44,105 @@ ExpressionTree::ExpressionTree() {
  * Frees the dynamic memory allocated for the tree
  */
 ExpressionTree::~ExpressionTree() {
-    delete _root;
+    TreeNode::Release(_root);
+}
+
+/**
+ * Copy constructor
+ * Runs in O(1) time: the copy shares all of its nodes with other.  Nodes are
+ * copied lazily, only along the paths that Simplify or Rebalance change.
+ * @param other the tree to be copied
+ */
+ExpressionTree::ExpressionTree(const ExpressionTree& other) {
+    _root = other._root != nullptr ? other._root->Retain() : nullptr;
+    _maxDepth = other._maxDepth;
+    _fSimplifyOnBuild = other._fSimplifyOnBuild;
+    _fReportErrors = other._fReportErrors;
+}
+
+/**
+ * Copy assignment operator
+ * Shares the nodes of rhs and releases the ones held before, O(1) time
+ * @param rhs the tree to be copied into this
+ * @return this to enable cascade assignments
+ */
+const ExpressionTree& ExpressionTree::operator=(const ExpressionTree& rhs) {
+    if (this != &rhs) {
+        TreeNode* root = rhs._root != nullptr ? rhs._root->Retain() : nullptr;
+
+        TreeNode::Release(_root);
+        _root = root;
+        _maxDepth = rhs._maxDepth;
+        _fSimplifyOnBuild = rhs._fSimplifyOnBuild;
+        _fReportErrors = rhs._fReportErrors;
+    }
+    return *this;
 }
 
 /**
  * Build an expression tree from its postfix representation
  * In case of error the stack is cleaned up.  Because it contains
  * pointers to TreeNodes, if any are left on the stack they must be
- * explicitly deleted
+ * explicitly released
+ * If a maximum depth has been set, postfix producing a deeper tree is
+ * rejected as soon as the limit is crossed; the limit applies to the tree as
+ * written, even when it is simplified while being built
+ * If simplify on build is set, each operator node is simplified as soon as
+ * it is created, so the unsimplified tree never exists.  The result is the
+ * same tree Simplify would produce.
+ * Errors are reported by writing Error to cout unless turned off with
+ * SetReportErrors, for callers that report them in their own order.
  * @param postfix string representation of tree
  * @return true if postfix valid and tree was built, false otherwise
  */
 bool ExpressionTree::BuildExpressionTree(const string& postfix) {
-    stringstream ss(postfix);
-    string token;
+    std::vector<string> tokens;
+
+    Tokenize(postfix, tokens);
+    return BuildExpressionTree(tokens);
+}
+
+/**
+ * Split postfix into its whitespace separated tokens
+ * @param postfix string representation of tree
+ * @param tokens receives the tokens, replacing its contents; strings already
+ * in it are reused so a vector kept across calls stops allocating
+ */
+void ExpressionTree::Tokenize(const string& postfix, std::vector<string>& tokens) {
+    size_t count = 0;
+    size_t i = 0;
+
+    while (i < postfix.length()) {
+        if (isspace((unsigned char) postfix[i])) {
+            i ++;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < postfix.length() && !isspace((unsigned char) postfix[i])) {
+            i ++;
+        }
+        if (count == tokens.size()) {
+            tokens.emplace_back();
+        }
+        tokens[count++].assign(postfix, start, i - start);
+    }
+    tokens.resize(count);
+}
+
+/**
+ * Build an expression tree from postfix already split into tokens, as
+ * BuildExpressionTree(postfix) does
+ * @param tokens tokens of the postfix, see Tokenize
+ * @return true if postfix valid and tree was built, false otherwise
+ */
+bool ExpressionTree::BuildExpressionTree(const std::vector<string>& tokens) {
     Stack <TreeNode*>TreeObjects;
+    Stack <size_t>Depths;
+
+    for (size_t t = 0; t < tokens.size(); t ++) {
+        const string& token = tokens[t];
 
-    while(ss >> token) {
         if(IsNumber(token)|| IsVariable(token)){
             if(IsNumber(token)) {
                 TreeNode *newObject = new TreeNode(NumberOperand, token);
@@ -57,12 +151,15 @@ bool ExpressionTree::BuildExpressionTree(const string& postfix) {
                 TreeNode *newObject = new TreeNode(VariableOperand, token);
                 TreeObjects.Push(newObject);
             }
+            if(_maxDepth!=0){
+                Depths.Push(1);
+            }
         } else if (IsOperator(token)){
             if(TreeObjects.Size()<2){
-                cout << "Error" << endl;
+                ReportError();
                 while(!TreeObjects.IsEmpty()){
                     TreeNode *A=TreeObjects.Pop();
-                    delete A;
+                    TreeNode::Release(A);
                 }
                 return false;
             }
@@ -70,26 +167,50 @@ bool ExpressionTree::BuildExpressionTree(const string& postfix) {
             TreeObjects.Pop();
             TreeNode *operand1=TreeObjects.Peek();
             TreeObjects.Pop();
+            size_t depth=0;
+
+            // Depths of the postfix as written are only tracked when limited
+            if(_maxDepth!=0){
+                size_t depth2=Depths.Pop();
+                size_t depth1=Depths.Pop();
+                depth=1+(depth1>depth2 ? depth1 : depth2);
+            }
+            if(_maxDepth!=0 && depth>_maxDepth){
+                ReportError();
+                TreeNode::Release(operand1);
+                TreeNode::Release(operand2);
+                while(!TreeObjects.IsEmpty()){
+                    TreeNode *A=TreeObjects.Pop();
+                    TreeNode::Release(A);
+                }
+                return false;
+            }
 
             TreeNode *newObject = new TreeNode(Operator, token);
             newObject->SetLeft(operand1);
             newObject->SetRight(operand2);
+            if(_fSimplifyOnBuild){
+                newObject=SimplifyNode(newObject);
+            }
             TreeObjects.Push(newObject);
+            if(_maxDepth!=0){
+                Depths.Push(depth);
+            }
 
         } else {
-            cout << "Error" << endl;
+            ReportError();
             while(!TreeObjects.IsEmpty()){
                 TreeNode *A =TreeObjects.Pop();
-                delete A;
+                TreeNode::Release(A);
             }
             return false;
         }
     }
     if(TreeObjects.Size()!=1){
-        cout << "Error" << endl;
+        ReportError();
         while(!TreeObjects.IsEmpty()){
            TreeNode *A= TreeObjects.Pop();
-           delete A;
+           TreeNode::Release(A);
         }
         return false;
     }
@@ -98,48 +219,103 @@ bool ExpressionTree::BuildExpressionTree(const string& postfix) {
 }
 
 /**
- * Recursively simplify an expression stored in an expression tree.  THe following simplications are performed
+ * Split a factor into a base and a constant exponent.  b ^ n with n a
+ * positive number gives b and n, any other factor gives itself and 1.
+ * @param factor factor of a product
+ * @param exponent receives the exponent
+ * @return the base, a subtree of factor
+ */
+static TreeNode* PowerBase(TreeNode* factor, int& exponent) {
+    if (factor->Type() == Operator && factor->Data() == "^" && factor->Right()->IsNumber()) {
+        int n = atoi(factor->Right()->Data().c_str());
+        if (n > 0) {
+            exponent = n;
+            return factor->Left();
+        }
+    }
+    exponent = 1;
+    return factor;
+}
+
+/**
+ * Build base ^ exponent, or just base when the exponent is 1
+ * @param base base of the power, the caller's reference is taken over
+ * @param exponent positive exponent
+ * @return power tree
+ */
+static TreeNode* MakePower(TreeNode* base, int exponent) {
+    if (exponent == 1) {
+        return base;
+    }
+
+    TreeNode* power = new TreeNode(Operator, "^");
+    power->SetLeft(base);
+    power->SetRight(new TreeNode(NumberOperand, to_string(exponent)));
+    return power;
+}
+
+/**
+ * Write the error message for invalid postfix, if errors are reported
+ */
+void ExpressionTree::ReportError() const {
+    if (_fReportErrors) {
+        cout << "Error" << endl;
+    }
+}
+
+/**
+ * Recursively simplify an expression stored in an expression tree.  Operator
+ * subtrees are simplified first, then SimplifyNode applies the rules to the
+ * node itself.
+ * @param tree expression tree, the caller's reference is taken over
+ * @return simplified tree
+ */
+TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
+    if (tree->Type() != Operator) {
+        return tree;
+    }
+    if (!tree->IsShared()) {
+        // Detach both children so the node's metadata is only recomputed once
+        TreeNode* left = tree->TakeLeft();
+        TreeNode* right = tree->TakeRight();
+
+        tree->SetLeft(SimplifyTree(left));
+        tree->SetRight(SimplifyTree(right));
+        return SimplifyNode(tree);
+    }
+    if (tree->Left()->Type() == Operator) {
+        tree = SimplifyLeft(tree);
+    }
+    if (tree->Right()->Type() == Operator) {
+        tree = SimplifyRight(tree);
+    }
+    return SimplifyNode(tree);
+}
+
+/**
+ * Simplify a single node whose subtrees are already simplified.  The following
+ * simplications are performed
  * - Addition, multiplication, and subtraction of constants is performed reducing the subtree to a leaf containing a number
- * - 0 + exp, exp + 0, exp - 0  will be reduced to exp, in general exp will a tree
- * - 1 * exp, exp * 1  will be reduced to exp, in general exp will a tree
+ * - 0 + x, x + 0, x - 0 where x is a variable will be reduced to x
+ * - 0 - x where x is a variable will be reduced to -x
  * - 0 * exp, exp * 0  will be reduce to a leaf containing 0
  * - exp - exp will be reduce to a leaf containing 0
- * - exp * number will be changed to number * exp
- * - (c1 * exp) + (c2 * exp) where c1, c2 are numbers  will be changed to (c1+c2) * exp
- * - (c1 * exp) - (c2 * exp) where c1, c2 are numbers will be changed to (c1-c2) * exp
- * pointers to TreeNodes, if any are left on the stack they must be
- * explicitly deleted
- * @param postfix string representation of tree
- * @return true if postfix valid and tree was built, false otherwise
+ * - Division and powers of constants are folded, except division by 0 and 0 to a negative power
+ * - exp ^ 0, 1 ^ exp become 1, exp ^ 1 and exp / 1 become exp, and 0 / exp becomes 0
+ * - (exp ^ m) ^ n becomes exp ^ (m*n) for positive numbers m and n, when
+ *   m*n is at most Polynomial::MaxDegree so Expand and Horner can still use it
+ * - Factors of a product with the same base are combined, see CombinePowers
+ * Because it only needs the children to be simplified already, it can also be
+ * applied to each node as it is built, see SetSimplifyOnBuild
+ * @param tree expression tree, the caller's reference is taken over
+ * @return simplified tree
  */
-TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
+TreeNode* ExpressionTree::SimplifyNode(TreeNode* tree) {
 
     if(IsOperator(tree->Data())) {
 
         if(tree->Data()=="*") {
-            if (tree->Left()->IsNumber() && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(tree->Right()->IsNumber() && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsVariable(tree->Left()->Data()) && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(IsVariable(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsOperator(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                if(IsSameTree(tree->Right(),tree->Left())) {
-                    string treeValue="0";
-                    TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                    delete tree;
-                    return returnTree;
-                } else{
-                    tree->SetLeft(SimplifyTree(tree->Left()));
-                    tree->SetRight(SimplifyTree(tree->Right()));
-                }
-            }
+            TreeNode* power = nullptr;
             if (tree->Left() != nullptr && tree->Left()->IsNumber() && tree->Right() != nullptr && tree->Right()->IsNumber()) {
                 stringstream ss;
                 stringstream ss2;
@@ -154,32 +330,34 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 final=num*num2;
                 string treeValue= to_string(final);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
+            } else if (tree->Left() != nullptr && tree->Right() != nullptr && (power = CombinePowers(tree)) != nullptr) {
+                return power;
             } else if (tree->Left() != nullptr && tree->Left()->IsZero() && tree->Right() != nullptr &&
                        tree->Right()->IsNumber()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if (tree->Left() != nullptr && tree->Left()->IsNumber() && tree->Right() != nullptr &&
                        tree->Right()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if (tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && IsVariable(tree->Right()->Data())) {
                 return tree;
             } else if(tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && tree->Right()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if(tree->Left()!=nullptr && IsVariable(tree->Right()->Data()) && tree->Right()!=nullptr && tree->Left()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             }else if(tree->Left()!=nullptr && tree->Left()->IsNumber() && tree->Right()!=nullptr && IsVariable(tree->Right()->Data())) {
                 return tree;
@@ -188,17 +366,17 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             }else if(tree->Left()!=nullptr && tree->Right()!=nullptr && tree->Left()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if(tree->Left()!=nullptr && tree->Right()!=nullptr && tree->Right()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if(tree->Left()!=nullptr && tree->Right()!=nullptr && tree->Left()->IsZero()) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
             } else {
@@ -208,29 +386,6 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
 
         }
         else if(tree->Data()=="-"){
-            if (tree->Left()->IsNumber() && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(tree->Right()->IsNumber() && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsVariable(tree->Left()->Data()) && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(IsVariable(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsOperator(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                if(IsSameTree(tree->Right(),tree->Left())) {
-                    string treeValue="0";
-                    TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                    delete tree;
-                    return returnTree;
-                } else{
-                    tree->SetLeft(SimplifyTree(tree->Left()));
-                    tree->SetRight(SimplifyTree(tree->Right()));
-                }
-            }
             if (tree->Left() != nullptr && tree->Left()->IsNumber() && tree->Right() != nullptr && tree->Right()->IsNumber()) {
                 stringstream ss;
                 stringstream ss2;
@@ -245,7 +400,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 final=num-num2;
                 string treeValue= to_string(final);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
             }
@@ -256,7 +411,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 ss2>>num2;
                 string treeValue= to_string(num2);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
             }
@@ -267,14 +422,14 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 ss>>num;
                 string treeValue= to_string(num);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
             }
             else if (tree->Left()!=nullptr && tree->Right()!=nullptr && IsSameTree(tree->Left(),tree->Right())) {
                 string treeValue="0";
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             }
             else if (tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && IsVariable(tree->Right()->Data())) {
@@ -282,7 +437,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             }
             else if(tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && tree->Right()->IsZero()) {
                 TreeNode * returnTree= new TreeNode(VariableOperand,tree->Left()->Data());
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             }
             else if(tree->Left()!=nullptr && IsVariable(tree->Right()->Data()) && tree->Right()!=nullptr && tree->Left()->IsZero()) {
@@ -290,7 +445,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                    string final;
                    final= r+tree->Right()->Data();
                 TreeNode * returnTree= new TreeNode(VariableOperand,final);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             }
             else if(tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && tree->Right()->IsNumber()) {
@@ -310,29 +465,6 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             }
         }
         else if(tree->Data()=="+") {
-            if (tree->Left()->IsNumber() && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(tree->Right()->IsNumber() && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsVariable(tree->Left()->Data()) && IsOperator(tree->Right()->Data())) {
-                tree->SetRight(SimplifyTree(tree->Right()));
-            }
-            if(IsVariable(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                tree->SetLeft(SimplifyTree(tree->Left()));
-            }
-            if(IsOperator(tree->Right()->Data()) && IsOperator(tree->Left()->Data())) {
-                if(IsSameTree(tree->Right(),tree->Left())) {
-                    string treeValue="0";
-                    TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                    delete tree;
-                    return returnTree;
-                } else{
-                    tree->SetLeft(SimplifyTree(tree->Left()));
-                    tree->SetRight(SimplifyTree(tree->Right()));
-                }
-            }
             if (tree->Left() != nullptr && tree->Left()->IsNumber() && tree->Right() != nullptr && tree->Right()->IsNumber()) {
                 stringstream ss;
                 stringstream ss2;
@@ -347,7 +479,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 final=num+num2;
                 string treeValue= to_string(final);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
 
             } else if (tree->Left() != nullptr && tree->Left()->IsZero() && tree->Right() != nullptr &&
@@ -358,7 +490,7 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 ss2>>num2;
                 string treeValue= to_string(num2);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if (tree->Left() != nullptr && tree->Left()->IsNumber() && tree->Right() != nullptr &&
                        tree->Right()->IsZero()) {
@@ -368,19 +500,19 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
                 ss>>num;
                 string treeValue= to_string(num);
                 TreeNode *returnTree = new TreeNode(NumberOperand,treeValue);
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             } else if (tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && IsVariable(tree->Right()->Data())) {
                 return tree;
             } else if(tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && tree->Right()->IsZero()) {
 
                  TreeNode * returnTree= new TreeNode(VariableOperand,tree->Left()->Data());
-                delete tree;
+                TreeNode::Release(tree);
                  return returnTree;
             } else if(tree->Left()!=nullptr && IsVariable(tree->Right()->Data()) && tree->Right()!=nullptr && tree->Left()->IsZero()) {
 
                 TreeNode * returnTree= new TreeNode(VariableOperand,tree->Right()->Data());
-                delete tree;
+                TreeNode::Release(tree);
                 return returnTree;
             }  else if(tree->Left()!=nullptr && IsVariable(tree->Left()->Data()) && tree->Right()!=nullptr && tree->Right()->IsNumber()) {
                 return tree;
@@ -395,6 +527,63 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
             }
 
         }
+        else if(tree->Data()=="^") {
+            if (tree->Left()->IsNumber() && tree->Right()->IsNumber() &&
+                !(tree->Left()->IsZero() && tree->Right()->Data()[0] == '-')) {
+                uint32_t base = (uint32_t) atoi(tree->Left()->Data().c_str());
+                uint32_t exponent = (uint32_t) atoi(tree->Right()->Data().c_str());
+                TreeNode *returnTree = new TreeNode(NumberOperand, to_string((int32_t) WrappedPower(base, exponent)));
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else if (tree->Right()->IsZero() || tree->Left()->IsOne()) {
+                TreeNode *returnTree = new TreeNode(NumberOperand, "1");
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else if (tree->Right()->IsOne()) {
+                TreeNode *returnTree = tree->Left()->Retain();
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else if (tree->Right()->IsNumber() && tree->Left()->Type() == Operator && tree->Left()->Data() == "^" &&
+                     tree->Left()->Right()->IsNumber()) {
+                int64_t inner = atoi(tree->Left()->Right()->Data().c_str());
+                int64_t outer = atoi(tree->Right()->Data().c_str());
+                if (inner > 0 && outer > 0 && inner * outer <= Polynomial::MaxDegree) {
+                    TreeNode *returnTree = MakePower(tree->Left()->Left()->Retain(), (int) (inner * outer));
+                    TreeNode::Release(tree);
+                    return returnTree;
+                }
+                return tree;
+            }
+            else {
+                return tree;
+            }
+        }
+        else if(tree->Data()=="/") {
+            if (tree->Left()->IsNumber() && tree->Right()->IsNumber() && !tree->Right()->IsZero()) {
+                uint32_t dividend = (uint32_t) atoi(tree->Left()->Data().c_str());
+                uint32_t divisor = (uint32_t) atoi(tree->Right()->Data().c_str());
+                TreeNode *returnTree = new TreeNode(NumberOperand, to_string((int32_t) WrappedDivide(dividend, divisor)));
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else if (tree->Right()->IsOne()) {
+                TreeNode *returnTree = tree->Left()->Retain();
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else if (tree->Left()->IsZero()) {
+                // 0 / exp is 0 for every exp, even 0, since division by 0 is defined as 0
+                TreeNode *returnTree = new TreeNode(NumberOperand, "0");
+                TreeNode::Release(tree);
+                return returnTree;
+            }
+            else {
+                return tree;
+            }
+        }
 
     } else {
             return tree;
@@ -404,25 +593,480 @@ TreeNode* ExpressionTree::SimplifyTree(TreeNode* tree) {
 }
 
 /**
- * Determine whether two tree structures represent the same expression
- * @param tree1 first tree structure
- * @param tree2 second tree structure
- * @return true if same, false otherwise
+ * Combine factors with the same base in a product whose subtrees are
+ * already simplified: b * b becomes b ^ 2 and b ^ m * b ^ n becomes
+ * b ^ (m+n).  When the left factor is itself a product, as in a chain
+ * x * y * x, a matching factor inside it is combined too, leaving the
+ * other factor times the power.  Constant factors are left to constant
+ * folding, and exponents are not combined past Polynomial::MaxDegree.
+ * @param tree product node, the caller's reference is taken over only if factors are combined
+ * @return combined tree, nullptr if there was nothing to combine
  */
-bool ExpressionTree::IsSameTree(TreeNode* tree1, TreeNode* tree2) const {
-    bool same;
-    same =false;
-    if( tree1->Data()==tree2->Data() ){
-        if(tree1->Left()!=nullptr && tree2->Left()!=nullptr && tree2->Right()!=nullptr &&tree1->Right()!=nullptr) {
-            if( IsSameTree(tree1->Right(), tree2->Right()) && IsSameTree(tree1->Left(), tree2->Left())) {
-            same = true;
+TreeNode* ExpressionTree::CombinePowers(TreeNode* tree) {
+    int rightExponent;
+    int leftExponent;
+    TreeNode* rightBase = PowerBase(tree->Right(), rightExponent);
+    TreeNode* leftBase = PowerBase(tree->Left(), leftExponent);
+    TreeNode* rest = nullptr;
+
+    if (rightBase->IsConstant()) {
+        return nullptr;
+    }
+    if (!IsSameTree(leftBase, rightBase)) {
+        TreeNode* left = tree->Left();
+        if (left->Type() != Operator || left->Data() != "*") {
+            return nullptr;
+        }
+        leftBase = PowerBase(left->Right(), leftExponent);
+        rest = left->Left();
+        if (!IsSameTree(leftBase, rightBase)) {
+            leftBase = PowerBase(left->Left(), leftExponent);
+            rest = left->Right();
+            if (!IsSameTree(leftBase, rightBase)) {
+                return nullptr;
+            }
+        }
+    }
+    if ((int64_t) leftExponent + rightExponent > Polynomial::MaxDegree) {
+        return nullptr;
+    }
+
+    TreeNode* power = MakePower(leftBase->Retain(), leftExponent + rightExponent);
+    if (rest != nullptr) {
+        TreeNode* product = new TreeNode(Operator, "*");
+        product->SetLeft(rest->Retain());
+        product->SetRight(power);
+        power = product;
+    }
+    TreeNode::Release(tree);
+    return power;
+}
+
+/**
+ * Apply a rewrite to one child of a node.  A node that is not shared is
+ * changed in place.  A shared node is copied, and only if the rewrite
+ * actually changed the child, so unchanged subtrees stay shared.
+ * @param tree node whose child is rewritten, the caller's reference is taken over
+ * @param fLeft true to rewrite the left child, false for the right
+ * @param rewrite method taking over a reference to the child and returning the replacement
+ * @return tree or its copy, holding the rewritten child
+ */
+TreeNode* ExpressionTree::RewriteChild(TreeNode* tree, bool fLeft, TreeNode* (ExpressionTree::*rewrite)(TreeNode*)) {
+    if (!tree->IsShared()) {
+        if (fLeft) {
+            tree->SetLeft((this->*rewrite)(tree->TakeLeft()));
+        } else {
+            tree->SetRight((this->*rewrite)(tree->TakeRight()));
+        }
+        return tree;
+    }
+
+    TreeNode* child = fLeft ? tree->Left() : tree->Right();
+    TreeNode* result = (this->*rewrite)(child->Retain());
+    if (result == child) {
+        TreeNode::Release(result);
+        return tree;
+    }
+
+    TreeNode* copy = tree->Clone();
+    TreeNode::Release(tree);
+    if (fLeft) {
+        copy->SetLeft(result);
+    } else {
+        copy->SetRight(result);
+    }
+    return copy;
+}
+
+/**
+ * Builds a balanced tree over operands[start..end) using the operator nodes
+ * in ops, which are consumed from the back
+ * @param operands operands in left to right order
+ * @param ops detached operator nodes, all holding the same associative operator
+ * @param start first operand
+ * @param end one past the last operand
+ * @return root of the balanced tree
+ */
+static TreeNode* BuildBalanced(std::vector<TreeNode*>& operands, std::vector<TreeNode*>& ops, size_t start, size_t end) {
+    if (end - start == 1) {
+        return operands[start];
+    }
+
+    size_t middle = start + (end - start) / 2;
+    TreeNode* node = ops.back();
+    ops.pop_back();
+    node->SetLeft(BuildBalanced(operands, ops, start, middle));
+    node->SetRight(BuildBalanced(operands, ops, middle, end));
+    return node;
+}
+
+/**
+ * Reshape chains of + and of * into balanced trees, reducing the depth of a
+ * chain of n operands from n to about log n.  Operands keep their left to
+ * right order and the operator nodes of the chain are reused unless they
+ * are shared with another tree, so usually no memory is allocated.  Only
+ * grouping changes, which cannot change the value under integer arithmetic
+ * that wraps on overflow.  Meant to be run after Simplify.  The tree is
+ * walked without recursion, so chains of any length can be rebalanced.
+ * @param tree expression tree, the caller's reference is taken over
+ * @return rebalanced tree
+ */
+TreeNode* ExpressionTree::RebalanceTree(TreeNode* tree) {
+    enum Step { Visit, Rejoin, Build };
+    struct Frame {
+        TreeNode* node;
+        Step step;
+        bool fShared;       // Rejoin: node is shared, copy it if a child changed
+        size_t operands;    // Build: number of operands of the chain
+    };
+    std::vector<Frame> pending(1, Frame{tree, Visit, false, 0});
+    std::vector<TreeNode*> results;
+    std::vector<std::vector<TreeNode*> > chainOps;
+
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        TreeNode* node = frame.node;
+        pending.pop_back();
+
+        if (frame.step == Build) {
+            // The operands are rebalanced, join them with the chain's operator nodes
+            std::vector<TreeNode*> operands(results.end() - frame.operands, results.end());
+            results.resize(results.size() - frame.operands);
+            results.push_back(BuildBalanced(operands, chainOps.back(), 0, operands.size()));
+            chainOps.pop_back();
+        } else if (frame.step == Rejoin) {
+            TreeNode* right = results.back();
+            results.pop_back();
+            TreeNode* left = results.back();
+            results.pop_back();
+
+            if (!frame.fShared) {
+                node->SetLeft(left);
+                node->SetRight(right);
+            } else if (left == node->Left() && right == node->Right()) {
+                TreeNode::Release(left);
+                TreeNode::Release(right);
+            } else {
+                TreeNode* copy = node->Clone();
+                TreeNode::Release(node);
+                copy->SetLeft(left);
+                copy->SetRight(right);
+                node = copy;
+            }
+            results.push_back(node);
+        } else if (node->Type() != Operator) {
+            results.push_back(node);
+        } else if (node->Data() != "+" && node->Data() != "*") {
+            bool fShared = node->IsShared();
+            pending.push_back(Frame{node, Rejoin, fShared, 0});
+            if (fShared) {
+                pending.push_back(Frame{node->Right()->Retain(), Visit, false, 0});
+                pending.push_back(Frame{node->Left()->Retain(), Visit, false, 0});
+            } else {
+                // Detach both children so the node's metadata is only recomputed once
+                TreeNode* left = node->TakeLeft();
+                pending.push_back(Frame{node->TakeRight(), Visit, false, 0});
+                pending.push_back(Frame{left, Visit, false, 0});
             }
         } else {
-            same=true;
+            // Detach the whole chain, collecting its operands left to right
+            string op = node->Data();
+            std::vector<TreeNode*> chain(1, node);
+            std::vector<TreeNode*> operands;
+
+            chainOps.push_back(std::vector<TreeNode*>());
+            while (!chain.empty()) {
+                TreeNode* link = chain.back();
+                chain.pop_back();
+
+                if (link->Type() == Operator && link->Data() == op) {
+                    if (link->IsShared()) {
+                        // Another tree still uses this node, leave it intact and use a fresh one
+                        chain.push_back(link->Right()->Retain());
+                        chain.push_back(link->Left()->Retain());
+                        TreeNode::Release(link);
+                        chainOps.back().push_back(new TreeNode(Operator, op));
+                    } else {
+                        chain.push_back(link->TakeRight());
+                        chain.push_back(link->TakeLeft());
+                        chainOps.back().push_back(link);
+                    }
+                } else {
+                    operands.push_back(link);
+                }
+            }
+
+            // Rebalance the operands first, leftmost on top so results stay in order
+            pending.push_back(Frame{nullptr, Build, false, operands.size()});
+            for (size_t i = operands.size(); i > 0; i --) {
+                pending.push_back(Frame{operands[i - 1], Visit, false, 0});
+            }
         }
+    }
+    return results.back();
+}
+
+/**
+ * Multiply out every product, replacing the tree by the sum of its terms.
+ * Like terms are combined and the terms written in a canonical order, so
+ * two trees that are equal as polynomials expand to the same tree.
+ * @return true if expanded, false if the tree uses an operator that does
+ * not form a polynomial, in which case it is left unchanged
+ */
+bool ExpressionTree::Expand() {
+    Polynomial polynomial;
 
+    if (_root == nullptr || !Polynomial::FromTree(_root, polynomial)) {
+        return false;
     }
-    return  same;
+    TreeNode::Release(_root);
+    _root = polynomial.ToTree();
+    return true;
+}
+
+/**
+ * Depth of the tree, cached in the root; a single leaf has depth 1
+ * @return depth, 0 for a null tree
+ */
+size_t ExpressionTree::Depth() const {
+    return _root == nullptr ? 0 : _root->Depth();
+}
+
+/**
+ * Count the operators of a tree without recursion
+ * @param tree expression tree
+ * @return number of operator nodes
+ */
+static size_t OperatorCount(const TreeNode* tree) {
+    std::vector<const TreeNode*> pending(1, tree);
+    size_t count = 0;
+
+    while (!pending.empty()) {
+        const TreeNode* node = pending.back();
+        pending.pop_back();
+
+        if (node->Type() == Operator) {
+            count++;
+            pending.push_back(node->Left());
+            pending.push_back(node->Right());
+        }
+    }
+    return count;
+}
+
+/**
+ * Rewrite each largest polynomial subtree in Horner form, see
+ * Polynomial::ToHornerTree.  A subtree is only replaced when its Horner
+ * form has fewer operators, so already factored subtrees such as
+ * (x+1)^8 are kept, and when it can be built within Polynomial::MaxWork
+ * steps.  Constant subtrees are skipped without a look.
+ * Subtrees that divide, or raise to a power that is not a number, are
+ * searched for polynomial subtrees below them.  Every subtree a failed
+ * conversion passed through is remembered, so no node is converted more
+ * than twice however deep the tree.  The tree is walked without
+ * recursion; unshared nodes are changed in place and shared ones copied
+ * only when a child changed, as in RewriteChild.
+ * @param tree expression tree, the caller's reference is taken over
+ * @return rewritten tree
+ */
+TreeNode* ExpressionTree::HornerTree(TreeNode* tree) {
+    struct Frame {
+        TreeNode* node;
+        bool fExpanded;
+        bool fShared;
+    };
+    std::unordered_set<const TreeNode*> failed;
+    std::vector<Frame> pending(1, Frame{tree, false, false});
+    std::vector<TreeNode*> results;
+
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        TreeNode* node = frame.node;
+        pending.pop_back();
+
+        if (frame.fExpanded) {
+            TreeNode* right = results.back();
+            results.pop_back();
+            TreeNode* left = results.back();
+            results.pop_back();
+
+            if (!frame.fShared) {
+                node->SetLeft(left);
+                node->SetRight(right);
+            } else if (left == node->Left() && right == node->Right()) {
+                TreeNode::Release(left);
+                TreeNode::Release(right);
+            } else {
+                TreeNode* copy = node->Clone();
+                TreeNode::Release(node);
+                copy->SetLeft(left);
+                copy->SetRight(right);
+                node = copy;
+            }
+            results.push_back(node);
+            continue;
+        }
+
+        // Constant subtrees have no variable to factor out
+        if (node->Type() != Operator || node->IsConstant()) {
+            results.push_back(node);
+            continue;
+        }
+
+        Polynomial polynomial;
+        if (Polynomial::FromTree(node, polynomial, &failed)) {
+            TreeNode* horner = polynomial.ToHornerTree();
+            if (horner == nullptr) {
+                // Too much work to factor, keep the polynomial as written
+                results.push_back(node);
+            } else if (OperatorCount(horner) < OperatorCount(node)) {
+                TreeNode::Release(node);
+                results.push_back(horner);
+            } else {
+                TreeNode::Release(horner);
+                results.push_back(node);
+            }
+            continue;
+        }
+
+        // Not a polynomial, look for polynomials in the children, left first
+        bool fShared = node->IsShared();
+        pending.push_back(Frame{node, true, fShared});
+        if (fShared) {
+            pending.push_back(Frame{node->Right()->Retain(), false, false});
+            pending.push_back(Frame{node->Left()->Retain(), false, false});
+        } else {
+            // Detach both children so the node's metadata is only recomputed once
+            TreeNode* left = node->TakeLeft();
+            pending.push_back(Frame{node->TakeRight(), false, false});
+            pending.push_back(Frame{left, false, false});
+        }
+    }
+    return results.back();
+}
+
+/**
+ * Number of nodes in the tree, cached in the root
+ * @return number of nodes, 0 for a null tree
+ */
+size_t ExpressionTree::Size() const {
+    return _root == nullptr ? 0 : _root->Size();
+}
+
+/**
+ * Compute the hash consed id of the tree from the current StructureTable.
+ * Trees built from the same postfix, on any thread using the same tables,
+ * get the same id, so results from different workers can be compared as
+ * integers.  Variables are keyed by their SymbolTable id, numbers by their
+ * wrapped value and operators by their character, so only variable names
+ * are interned as symbols.  The tree is walked without recursion.
+ * @return structure id, NoInternId for a null tree
+ */
+uint32_t ExpressionTree::StructureId() const {
+    struct Frame {
+        const TreeNode* node;
+        bool fExpanded;
+    };
+    StructureTable& structures = StructureTable::Current();
+    std::vector<Frame> pending;
+    std::vector<uint32_t> ids;
+
+    if (_root == nullptr) {
+        return NoInternId;
+    }
+    pending.push_back({_root, false});
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        const TreeNode* node = frame.node;
+        pending.pop_back();
+
+        if (node->Type() == VariableOperand) {
+            ids.push_back(structures.Intern(VariableOperand, node->Symbol(), NoInternId, NoInternId));
+        } else if (node->Type() == NumberOperand) {
+            ids.push_back(structures.Intern(NumberOperand, (uint32_t) atoi(node->Data().c_str()), NoInternId, NoInternId));
+        } else if (!frame.fExpanded) {
+            pending.push_back({node, true});
+            pending.push_back({node->Right(), false});
+            pending.push_back({node->Left(), false});
+        } else {
+            uint32_t right = ids.back();
+            ids.pop_back();
+            uint32_t left = ids.back();
+            ids.pop_back();
+            ids.push_back(structures.Intern(Operator, (unsigned char) node->Data()[0], left, right));
+        }
+    }
+    return ids.back();
+}
+
+/**
+ * Compare two trees node by node, without recursion
+ * @param tree1 first tree
+ * @param tree2 second tree
+ * @return true if the trees are identical, operand order included
+ */
+static bool IsIdentical(const TreeNode* tree1, const TreeNode* tree2) {
+    std::vector<std::pair<const TreeNode*, const TreeNode*> > pending(1, std::make_pair(tree1, tree2));
+
+    while (!pending.empty()) {
+        const TreeNode* node1 = pending.back().first;
+        const TreeNode* node2 = pending.back().second;
+        pending.pop_back();
+
+        if (node1 == node2) {
+            continue;
+        }
+        if (node1->Type() != node2->Type() || node1->Hash() != node2->Hash() || node1->Data() != node2->Data()) {
+            return false;
+        }
+        if (node1->Type() == Operator) {
+            pending.push_back(std::make_pair(node1->Left(), node2->Left()));
+            pending.push_back(std::make_pair(node1->Right(), node2->Right()));
+        }
+    }
+    return true;
+}
+
+/**
+ * Determine whether two tree structures represent the same expression.
+ * The trees are compared in canonical form, so operands of + and * may
+ * appear in any order and be grouped in any way, and the numbers in a chain
+ * are folded together.  Neither changes which variables appear, so trees
+ * whose cached variables differ are rejected at once, as are trees whose
+ * cached canonical hashes differ.  Trees with equal hashes are first checked
+ * for being identical, so the canonical forms are only built for trees that
+ * are most likely the same expression.
+ * @param tree1 first tree structure
+ * @param tree2 second tree structure
+ * @return true if same, false otherwise
+ */
+bool ExpressionTree::IsSameTree(TreeNode* tree1, TreeNode* tree2) const {
+    if (tree1 == tree2) {
+        return true;
+    }
+    if (tree1->Variables() != tree2->Variables()) {
+        return false;
+    }
+    if (tree1->Type() == VariableOperand && tree2->Type() == VariableOperand) {
+        return tree1->Symbol() == tree2->Symbol();
+    }
+    if (tree1->Type() != Operator || tree2->Type() != Operator) {
+        return tree1->Type() == tree2->Type() && tree1->Data() == tree2->Data();
+    }
+    if (tree1->CanonicalHash() != tree2->CanonicalHash()) {
+        return false;
+    }
+    if (tree1->Hash() == tree2->Hash() && IsIdentical(tree1, tree2)) {
+        return true;
+    }
+
+    CanonicalNode* canonical1 = CanonicalNode::Build(tree1);
+    CanonicalNode* canonical2 = CanonicalNode::Build(tree2);
+    bool same = CanonicalNode::IsSame(canonical1, canonical2);
+
+    delete canonical1;
+    delete canonical2;
+    return same;
 }
 
 /**
@@ -485,11 +1129,11 @@ bool IsVariable(string token)  {
 }
 
 /**
- * CHecks if the stirng is a +, -, or *
+ * CHecks if the stirng is a +, -, *, /, or ^
  * @param token a string
  * @return true if its an operator
  */
 bool IsOperator(string token)  {
-    return (token.length() == 1 && (token[0] == '+' || token[0] == '-' || token[0] == '*'));
+    return (token.length() == 1 && (token[0] == '+' || token[0] == '-' || token[0] == '*' || token[0] == '/' || token[0] == '^'));
 }
 
@@ -6,6 +6,9 @@
 #ifndef EXPRESSIONTREE_H
 #define EXPRESSIONTREE_H
 
+#include <vector>
+#include "Fingerprint.h"
+#include "TreeEmitter.h"
 #include "TreeNode.h"
 
 class ExpressionTree {
@@ -13,8 +16,28 @@ public:
     ExpressionTree();
     ~ExpressionTree();
 
+    ExpressionTree(const ExpressionTree& other);
+    const ExpressionTree& operator=(const ExpressionTree& rhs);
+
     bool BuildExpressionTree(const string& postfix);
+    bool BuildExpressionTree(const std::vector<string>& tokens);
+    static void Tokenize(const string& postfix, std::vector<string>& tokens);
+    void SetMaxDepth(size_t maxDepth) { _maxDepth = maxDepth; };
+    void SetSimplifyOnBuild(bool fSimplify) { _fSimplifyOnBuild = fSimplify; };
+    void SetReportErrors(bool fReport) { _fReportErrors = fReport; };
     void Simplify() { _root = SimplifyTree(_root); };
+    void Rebalance() { _root = RebalanceTree(_root); };
+    bool Expand();
+    void Horner() { _root = HornerTree(_root); };
+
+    const TreeNode* Root() const { return _root; };
+    size_t Size() const;
+    size_t Depth() const;
+    uint32_t StructureId() const;
+    ExpressionFingerprint Fingerprint() const { return Fingerprinter().Compute(_root); };
+    bool IsSameExpression(const ExpressionTree& other) const { return IsSameTree(_root, other._root); };
+
+    void Write(OutputSink& sink, OutputFormat format) const { TreeEmitter(sink).Emit(_root, format); };
 
     friend ostream& operator<<(ostream& os, const ExpressionTree& tree) {
         return os << tree.ToString(tree._root, false);
@@ -22,10 +45,21 @@ public:
 
 private:
     TreeNode* SimplifyTree(TreeNode* tree);
+    TreeNode* SimplifyNode(TreeNode* tree);
+    TreeNode* CombinePowers(TreeNode* tree);
+    TreeNode* RebalanceTree(TreeNode* tree);
+    TreeNode* HornerTree(TreeNode* tree);
+    TreeNode* RewriteChild(TreeNode* tree, bool fLeft, TreeNode* (ExpressionTree::*rewrite)(TreeNode*));
+    TreeNode* SimplifyLeft(TreeNode* tree) { return RewriteChild(tree, true, &ExpressionTree::SimplifyTree); };
+    TreeNode* SimplifyRight(TreeNode* tree) { return RewriteChild(tree, false, &ExpressionTree::SimplifyTree); };
     string ToString(TreeNode* tree, bool NeedOuterParen) const;
     bool IsSameTree(TreeNode* tree1, TreeNode* tree2) const;
+    void ReportError() const;
 
     TreeNode* _root;
+    size_t _maxDepth;
+    bool _fSimplifyOnBuild;
+    bool _fReportErrors;
 };
 
 #endif //EXPRESSIONTREE_H
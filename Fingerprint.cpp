@@ -0,0 +1,165 @@
+//
+// Implements the Fingerprinter Class
+// Author: Max Benson
+// Date: 01/17/2022
+//
+
+#include <stdlib.h>
+#include <vector>
+#include "Fingerprint.h"
+
+// The Mersenne prime 2^61-1
+static const uint64_t Prime = (1ULL << 61) - 1;
+
+/**
+ * Reduce a value below 2^122 modulo 2^61-1
+ * @param value value to reduce
+ * @return value mod 2^61-1
+ */
+static uint64_t Reduce(unsigned __int128 value) {
+    uint64_t low = (uint64_t) (value & Prime);
+    uint64_t high = (uint64_t) (value >> 61);
+    uint64_t sum = low + high;
+
+    sum = (sum & Prime) + (sum >> 61);
+    return sum >= Prime ? sum - Prime : sum;
+}
+
+static uint64_t AddMod(uint64_t a, uint64_t b) {
+    uint64_t sum = a + b;
+    return sum >= Prime ? sum - Prime : sum;
+}
+
+static uint64_t SubMod(uint64_t a, uint64_t b) {
+    return a >= b ? a - b : a + Prime - b;
+}
+
+static uint64_t MulMod(uint64_t a, uint64_t b) {
+    return Reduce((unsigned __int128) a * b);
+}
+
+static uint64_t PowMod(uint64_t base, uint32_t exponent) {
+    uint64_t result = 1;
+
+    while (exponent != 0) {
+        if (exponent & 1) {
+            result = MulMod(result, base);
+        }
+        base = MulMod(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+/**
+ * Value of a decimal number modulo the prime; a leading - negates it
+ * @param data decimal digits
+ * @return value mod 2^61-1
+ */
+static uint64_t NumberValue(const string& data) {
+    bool fNegative = data.length() > 0 && data[0] == '-';
+    uint64_t value = 0;
+
+    for (size_t i = fNegative ? 1 : 0; i < data.length(); i ++) {
+        value = AddMod(MulMod(value, 10), (uint64_t) (data[i] - '0'));
+    }
+    return fNegative ? SubMod(0, value) : value;
+}
+
+/**
+ * SplitMix64 finalizer, spreads the bits of its input
+ * @param x value to mix
+ * @return mixed value
+ */
+static uint64_t Mix(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * Pseudo-random value of a variable at one of the evaluation points
+ * @param name variable name
+ * @param point which evaluation point
+ * @return value in [0, 2^61-1)
+ */
+uint64_t Fingerprinter::VariableValue(const string& name, size_t point) const {
+    // FNV-1a, so values do not depend on the standard library's string hash
+    uint64_t hash = 0xCBF29CE484222325ULL;
+
+    for (size_t i = 0; i < name.length(); i ++) {
+        hash = (hash ^ (unsigned char) name[i]) * 0x100000001B3ULL;
+    }
+    return Mix(Mix(hash ^ _seed) + point) % Prime;
+}
+
+/**
+ * Fingerprint an expression tree.  The tree is walked without recursion.
+ * @param tree expression tree
+ * @return fingerprint
+ */
+ExpressionFingerprint Fingerprinter::Compute(const TreeNode* tree) const {
+    struct Frame {
+        const TreeNode* node;
+        bool fExpanded;
+    };
+    std::vector<Frame> pending;
+    std::vector<ExpressionFingerprint> values;
+
+    pending.push_back({tree, false});
+    while (!pending.empty()) {
+        Frame frame = pending.back();
+        const TreeNode* node = frame.node;
+        pending.pop_back();
+
+        if (node->Type() == NumberOperand) {
+            ExpressionFingerprint value;
+            uint64_t number = NumberValue(node->Data());
+            for (size_t i = 0; i < ExpressionFingerprint::Points; i ++) {
+                value.values[i] = number;
+            }
+            values.push_back(value);
+        } else if (node->Type() == VariableOperand) {
+            // Simplification writes 0 - x as the variable -x
+            const string& name = node->Data();
+            bool fNegated = name.length() > 1 && name[0] == '-';
+            ExpressionFingerprint value;
+            for (size_t i = 0; i < ExpressionFingerprint::Points; i ++) {
+                uint64_t v = fNegated ? VariableValue(name.substr(1), i) : VariableValue(name, i);
+                value.values[i] = fNegated ? SubMod(0, v) : v;
+            }
+            values.push_back(value);
+        } else if (!frame.fExpanded) {
+            pending.push_back({node, true});
+            pending.push_back({node->Right(), false});
+            pending.push_back({node->Left(), false});
+        } else {
+            ExpressionFingerprint right = values.back();
+            values.pop_back();
+            ExpressionFingerprint& left = values.back();
+            char op = node->Data()[0];
+            // A power with a constant exponent is still a polynomial, x^3 equals x*x*x
+            int exponent = -1;
+            if (op == '^' && node->Right()->IsNumber()) {
+                exponent = atoi(node->Right()->Data().c_str());
+            }
+
+            for (size_t i = 0; i < ExpressionFingerprint::Points; i ++) {
+                if (op == '+') {
+                    left.values[i] = AddMod(left.values[i], right.values[i]);
+                } else if (op == '-') {
+                    left.values[i] = SubMod(left.values[i], right.values[i]);
+                } else if (op == '*') {
+                    left.values[i] = MulMod(left.values[i], right.values[i]);
+                } else if (exponent >= 0) {
+                    left.values[i] = PowMod(left.values[i], (uint32_t) exponent);
+                } else {
+                    // Division and other powers are not polynomials, only identical operands match
+                    left.values[i] = Mix(Mix(left.values[i] ^ (uint64_t) op) + right.values[i]) % Prime;
+                }
+            }
+        }
+    }
+    return values.back();
+}
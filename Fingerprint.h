@@ -0,0 +1,54 @@
+//
+// Interface Definition for the Fingerprinter Class
+// Author: Max Benson
+// Date: 01/17/2022
+//
+// Probabilistic equivalence test for expressions.  An expression is evaluated
+// at a few pseudo-random points modulo the prime 2^61-1.  Two expressions
+// that are equal as polynomials always get the same fingerprint.  Two that
+// differ get the same fingerprint with probability at most (d/p)^Points,
+// where d is the degree (Schwartz-Zippel).  The variable values depend only
+// on the seed and the variable names, so fingerprints can be compared across
+// trees, threads and runs.  Division, and powers whose exponent is not a
+// number, are not polynomials; they are hashed from their operands instead,
+// so they match only when their operands match.
+//
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdint.h>
+#include "TreeNode.h"
+
+struct ExpressionFingerprint {
+    static const size_t Points = 4;
+
+    uint64_t values[Points];
+
+    bool operator==(const ExpressionFingerprint& other) const {
+        for (size_t i = 0; i < Points; i ++) {
+            if (values[i] != other.values[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+    bool operator!=(const ExpressionFingerprint& other) const { return !(*this == other); }
+};
+
+struct ExpressionFingerprintHash {
+    size_t operator()(const ExpressionFingerprint& fingerprint) const { return (size_t) fingerprint.values[0]; }
+};
+
+class Fingerprinter {
+public:
+    Fingerprinter(uint64_t seed = 0x5EED5EED5EED5EEDULL) : _seed(seed) {};
+
+    ExpressionFingerprint Compute(const TreeNode* tree) const;
+
+private:
+    uint64_t VariableValue(const string& name, size_t point) const;
+
+    uint64_t _seed;
+};
+
+#endif //FINGERPRINT_H
@@ -0,0 +1,244 @@
+//
+// Implements the SymbolTable and StructureTable Classes
+// Author: Max Benson
+// Date: 01/10/2022
+//
+
+#include <assert.h>
+#include <atomic>
+#include <functional>
+#include "InternTable.h"
+
+// Distinguishes tables so a thread's cache is never used with the wrong one
+static std::atomic<uint64_t> nextSerial(1);
+
+// Per-thread cache of names already interned in one SymbolTable
+struct SymbolCache {
+    uint64_t serial = 0;
+    std::unordered_map<string, uint32_t> ids;
+};
+
+static thread_local SymbolCache symbolCache;
+
+// Tables installed by SetCurrent for the calling thread, nullptr for the global ones
+static thread_local SymbolTable* currentSymbols = nullptr;
+static thread_local StructureTable* currentStructures = nullptr;
+
+/**
+ * Default constructor
+ * Creates an empty table
+ */
+SymbolTable::SymbolTable() {
+    _serial = nextSerial.fetch_add(1);
+}
+
+/**
+ * The table shared by the whole process, used for the variables of every
+ * TreeNode built on a thread that has not installed its own
+ * @return the global symbol table
+ */
+SymbolTable& SymbolTable::Global() {
+    static SymbolTable table;
+    return table;
+}
+
+/**
+ * The table used by the calling thread
+ * @return the table installed by SetCurrent, otherwise the global table
+ */
+SymbolTable& SymbolTable::Current() {
+    return currentSymbols != nullptr ? *currentSymbols : Global();
+}
+
+/**
+ * Install the table the calling thread uses from now on
+ * @param table table to use, nullptr to go back to the global table
+ */
+void SymbolTable::SetCurrent(SymbolTable* table) {
+    currentSymbols = table;
+}
+
+/**
+ * Find the id of a name, adding the name if it is new
+ * @param name symbol name
+ * @return id of the name, the same for every call with the same name
+ */
+uint32_t SymbolTable::Intern(const string& name) {
+    if (symbolCache.serial != _serial) {
+        symbolCache.ids.clear();
+        symbolCache.serial = _serial;
+    }
+    std::unordered_map<string, uint32_t>::const_iterator cached = symbolCache.ids.find(name);
+    if (cached != symbolCache.ids.end()) {
+        return cached->second;
+    }
+
+    size_t shardIndex = std::hash<string>()(name) & (ShardCount - 1);
+    Shard& shard = _shards[shardIndex];
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        std::unordered_map<string, uint32_t>::const_iterator found = shard.ids.find(name);
+
+        if (found != shard.ids.end()) {
+            id = found->second;
+        } else {
+            assert(shard.names.size() < (NoInternId >> ShardBits));
+            id = (uint32_t) ((shard.names.size() << ShardBits) | shardIndex);
+            shard.names.push_back(name);
+            shard.ids.emplace(name, id);
+        }
+    }
+    symbolCache.ids.emplace(name, id);
+    return id;
+}
+
+/**
+ * Find the id of a name without adding it
+ * @param name symbol name
+ * @param id receives the id if found
+ * @return true if the name has been interned, false otherwise
+ */
+bool SymbolTable::Find(const string& name, uint32_t& id) {
+    Shard& shard = _shards[std::hash<string>()(name) & (ShardCount - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<string, uint32_t>::const_iterator found = shard.ids.find(name);
+
+    if (found == shard.ids.end()) {
+        return false;
+    }
+    id = found->second;
+    return true;
+}
+
+/**
+ * Look up the name of an id.  Names never move once interned, so the
+ * reference stays valid for the life of the table.
+ * @param id id returned by Intern
+ * @return the name
+ */
+const string& SymbolTable::Name(uint32_t id) {
+    Shard& shard = _shards[id & (ShardCount - 1)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    return shard.names[id >> ShardBits];
+}
+
+/**
+ * Number of names interned
+ * @return count of names
+ */
+size_t SymbolTable::Size() {
+    size_t size = 0;
+
+    for (size_t i = 0; i < ShardCount; i ++) {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        size += _shards[i].names.size();
+    }
+    return size;
+}
+
+/**
+ * Forget every name.  Ids handed out before are no longer valid, so the
+ * table must not be in use by another thread, and no tree built with it may
+ * still be alive.
+ */
+void SymbolTable::Clear() {
+    for (size_t i = 0; i < ShardCount; i ++) {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        _shards[i].ids.clear();
+        _shards[i].names.clear();
+    }
+    // Thread caches of the old names no longer match
+    _serial = nextSerial.fetch_add(1);
+}
+
+/**
+ * The table shared by the whole process, used by every thread that has not
+ * installed its own
+ * @return the global structure table
+ */
+StructureTable& StructureTable::Global() {
+    static StructureTable table;
+    return table;
+}
+
+/**
+ * The table used by the calling thread
+ * @return the table installed by SetCurrent, otherwise the global table
+ */
+StructureTable& StructureTable::Current() {
+    return currentStructures != nullptr ? *currentStructures : Global();
+}
+
+/**
+ * Install the table the calling thread uses from now on
+ * @param table table to use, nullptr to go back to the global table
+ */
+void StructureTable::SetCurrent(StructureTable* table) {
+    currentStructures = table;
+}
+
+/**
+ * Find the id of a node given its kind, a key for its data, and the
+ * structure ids of its children, adding it if it's new
+ * @param kind node type
+ * @param data symbol id of a variable, value of a number, or operator character
+ * @param left structure id of the left subtree or NoInternId
+ * @param right structure id of the right subtree or NoInternId
+ * @return structure id, equal for structurally identical subtrees
+ */
+uint32_t StructureTable::Intern(uint32_t kind, uint32_t data, uint32_t left, uint32_t right) {
+    Key key = {kind, data, left, right};
+    size_t shardIndex = KeyHash()(key) & (ShardCount - 1);
+    Shard& shard = _shards[shardIndex];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    std::unordered_map<Key, uint32_t, KeyHash>::const_iterator found = shard.ids.find(key);
+
+    if (found != shard.ids.end()) {
+        return found->second;
+    }
+    assert(shard.ids.size() < (NoInternId >> ShardBits));
+    uint32_t id = (uint32_t) ((shard.ids.size() << ShardBits) | shardIndex);
+    shard.ids.emplace(key, id);
+    return id;
+}
+
+/**
+ * Number of distinct subtrees interned
+ * @return count of subtrees
+ */
+size_t StructureTable::Size() {
+    size_t size = 0;
+
+    for (size_t i = 0; i < ShardCount; i ++) {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        size += _shards[i].ids.size();
+    }
+    return size;
+}
+
+/**
+ * Forget every subtree.  Ids handed out before are no longer valid, so the
+ * table must not be in use by another thread.
+ */
+void StructureTable::Clear() {
+    for (size_t i = 0; i < ShardCount; i ++) {
+        std::lock_guard<std::mutex> lock(_shards[i].mutex);
+        _shards[i].ids.clear();
+    }
+}
+
+/**
+ * Hash of a structure key
+ * @param key key to hash
+ * @return hash value
+ */
+size_t StructureTable::KeyHash::operator()(const Key& key) const {
+    uint64_t h = key.kind;
+
+    h = h * 0x9E3779B97F4A7C15ULL + key.data;
+    h = h * 0x9E3779B97F4A7C15ULL + key.left;
+    h = h * 0x9E3779B97F4A7C15ULL + key.right;
+    return (size_t) (h ^ (h >> 29));
+}
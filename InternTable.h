@@ -0,0 +1,109 @@
+//
+// Interface Definition for the SymbolTable and StructureTable Classes
+// Author: Max Benson
+// Date: 01/10/2022
+//
+// Thread safe intern tables, normally shared by every thread of the process.
+//
+// SymbolTable gives each distinct variable name a small integer id, so two
+// variable nodes, even from trees built on different threads, can be
+// compared with one integer compare.  StructureTable does the same for whole
+// subtrees (hash consing): structurally identical subtrees get the same id.
+//
+// Both tables are split into shards, each with its own lock, chosen by hash
+// so that threads working on different keys rarely contend.  SymbolTable
+// also keeps a per-thread cache in front of the shards, so looking up a name
+// a thread has seen before takes no lock at all.  Ids are never reused or
+// changed until the table is cleared.
+//
+// Code interns through Current(), which is the process wide table unless
+// the calling thread installed one of its own with SetCurrent.  The server's
+// workers each install their own tables and clear them after every batch, so
+// a long running daemon does not keep every name and subtree it has seen.
+// Ids from different tables mean different things and must not be compared.
+//
+#ifndef INTERNTABLE_H
+#define INTERNTABLE_H
+
+#include <stdint.h>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+using std::string;
+
+// Id reserved to mean "no symbol" or "no subtree"
+static const uint32_t NoInternId = 0xFFFFFFFF;
+
+class SymbolTable {
+public:
+    SymbolTable();
+
+    SymbolTable(const SymbolTable&) = delete;
+    const SymbolTable& operator=(const SymbolTable&) = delete;
+
+    static SymbolTable& Global();
+    static SymbolTable& Current();
+    static void SetCurrent(SymbolTable* table);
+
+    uint32_t Intern(const string& name);
+    bool Find(const string& name, uint32_t& id);
+    const string& Name(uint32_t id);
+    size_t Size();
+    void Clear();
+
+private:
+    static const size_t ShardBits = 6;
+    static const size_t ShardCount = 1 << ShardBits;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<string, uint32_t> ids;
+        std::deque<string> names;
+    };
+
+    Shard _shards[ShardCount];
+    uint64_t _serial;
+};
+
+class StructureTable {
+public:
+    StructureTable() {};
+
+    StructureTable(const StructureTable&) = delete;
+    const StructureTable& operator=(const StructureTable&) = delete;
+
+    static StructureTable& Global();
+    static StructureTable& Current();
+    static void SetCurrent(StructureTable* table);
+
+    uint32_t Intern(uint32_t kind, uint32_t data, uint32_t left, uint32_t right);
+    size_t Size();
+    void Clear();
+
+private:
+    static const size_t ShardBits = 6;
+    static const size_t ShardCount = 1 << ShardBits;
+
+    struct Key {
+        uint32_t kind;
+        uint32_t data;
+        uint32_t left;
+        uint32_t right;
+
+        bool operator==(const Key& other) const {
+            return kind == other.kind && data == other.data && left == other.left && right == other.right;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<Key, uint32_t, KeyHash> ids;
+    };
+
+    Shard _shards[ShardCount];
+};
+
+#endif //INTERNTABLE_H
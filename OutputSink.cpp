@@ -0,0 +1,71 @@
+//
+// Implements the OutputSink Class
+// Author: Max Benson
+// Date: 11/29/2021
+//
+
+#include <string.h>
+#include "OutputSink.h"
+
+/**
+ * Constructor
+ * @param os stream receiving the output
+ * @param capacity size of the buffer in bytes
+ */
+OutputSink::OutputSink(ostream& os, size_t capacity) : _os(os) {
+    _capacity = capacity > 0 ? capacity : 1;
+    _buffer = new char[_capacity];
+    _size = 0;
+}
+
+/**
+ * Destructor
+ * Flushes anything still buffered and frees the buffer
+ */
+OutputSink::~OutputSink() {
+    Flush();
+    delete[] _buffer;
+}
+
+/**
+ * Append a block of characters.  Blocks larger than the buffer bypass it.
+ * @param data characters to write
+ * @param length number of characters
+ */
+void OutputSink::Write(const char* data, size_t length) {
+    if (_size + length > _capacity) {
+        Flush();
+        if (length > _capacity) {
+            _os.write(data, length);
+            return;
+        }
+    }
+    memcpy(_buffer + _size, data, length);
+    _size += length;
+}
+
+/**
+ * Append the decimal representation of a number
+ * @param number value to write
+ */
+void OutputSink::WriteNumber(size_t number) {
+    char digits[24];
+    size_t length = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - length] = '0' + number % 10;
+        number /= 10;
+        length++;
+    } while (number > 0);
+    Write(digits + sizeof(digits) - length, length);
+}
+
+/**
+ * Hand the buffered characters to the stream
+ */
+void OutputSink::Flush() {
+    if (_size > 0) {
+        _os.write(_buffer, _size);
+        _size = 0;
+    }
+}
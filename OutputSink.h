@@ -0,0 +1,47 @@
+//
+// Interface Definition for the OutputSink Class
+// Author: Max Benson
+// Date: 11/29/2021
+//
+// A buffered character sink in front of an ostream.  Emitters write small
+// pieces (single characters, tokens) straight into the buffer, which is
+// handed to the stream only when it fills, so no temporary strings are
+// built for subtrees.
+//
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <string.h>
+#include <iostream>
+#include <string>
+using std::ostream;
+using std::string;
+
+class OutputSink {
+public:
+    OutputSink(ostream& os, size_t capacity = 1 << 16);
+    ~OutputSink();
+
+    OutputSink(const OutputSink&) = delete;
+    const OutputSink& operator=(const OutputSink&) = delete;
+
+    void Put(char c) {
+        if (_size == _capacity) {
+            Flush();
+        }
+        _buffer[_size++] = c;
+    };
+    void Write(const char* data, size_t length);
+    void Write(const string& s) { Write(s.data(), s.length()); };
+    void Write(const char* text) { Write(text, strlen(text)); };
+    void WriteNumber(size_t number);
+    void Flush();
+
+private:
+    ostream& _os;
+    char* _buffer;
+    size_t _size;
+    size_t _capacity;
+};
+
+#endif //OUTPUTSINK_H
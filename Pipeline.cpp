@@ -0,0 +1,351 @@
+//
+// Pipelined simplification of a stream of postfix expressions
+// Author: Max Benson
+// Date: 02/07/2022
+//
+// Reading, tokenizing, simplifying, and writing run on four threads so that
+// I/O and compute overlap.  Work moves between them in batches of lines:
+//
+//   reader      fills a batch with postfix lines
+//   tokenizer   splits each line into its tokens
+//   simplifier  builds and simplifies a tree from each line's tokens
+//   writer      formats the trees into the output
+//
+// Each pair of neighbouring stages is joined by an SpscQueue of batch
+// pointers, so a batch and everything in it changes hands without being
+// copied.  A fixed set of batches circulates: the writer hands finished
+// batches back to the reader, which overwrites the lines in place, the
+// tokenizer reuses the token strings, and the simplifier drops the old
+// trees before building new ones, so their nodes return to the
+// simplifier's own node pool.  A null batch marks the end of the input.
+//
+// The writer runs on the calling thread.  A stage that finds its queue full
+// or empty spins briefly and then sleeps until the stage on the other side
+// of the queue wakes it, so an idle pipeline uses no CPU.  The time spent
+// waiting is what the statistics report as the stage being idle.
+//
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using std::cerr;
+using std::endl;
+using std::getline;
+using std::string;
+
+#include "ExpressionTree.h"
+#include "OutputSink.h"
+#include "Pipeline.h"
+#include "SpscQueue.h"
+
+// Most lines gathered into one batch
+static const size_t BatchSize = 256;
+
+// Number of batches in circulation, also the capacity of each queue
+static const size_t BatchCount = 8;
+
+// Failed attempts before a waiting stage goes to sleep
+static const unsigned SpinLimit = 64;
+
+typedef std::chrono::steady_clock Clock;
+
+struct PipelineBatch {
+    std::vector<string> lines;
+    std::vector<std::vector<string> > tokens;
+    std::vector<ExpressionTree> trees;
+    size_t count = 0;
+};
+
+typedef std::unique_ptr<PipelineBatch> BatchPtr;
+
+/**
+ * The queue from one stage to the next, and what a stage needs to sleep on
+ * it.  The queue itself never locks; the mutex is only taken by a stage
+ * going to sleep and by the other stage when it sees a sleeper to wake.
+ */
+struct BatchLink {
+    BatchLink() : queue(BatchCount), sleepers(0) {};
+
+    SpscQueue<BatchPtr> queue;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::atomic<int> sleepers;
+};
+
+/**
+ * Time one stage spent waiting on its queues, and how full the queue it
+ * takes work from was each time it took some
+ */
+struct StageStats {
+    Clock::duration waiting = Clock::duration::zero();
+    size_t pops = 0;
+    size_t queued = 0;
+};
+
+/**
+ * Wake the stage sleeping on a link, if any, after pushing or popping.
+ * The fence orders the queue update before reading sleepers, pairing with
+ * the fence in WaitFor, so either the sleeper sees the update or this sees
+ * the sleeper.
+ * @param link link just pushed to or popped from
+ */
+static void Wake(BatchLink& link) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (link.sleepers.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(link.mutex);
+        link.wake.notify_all();
+    }
+}
+
+/**
+ * Retry an operation on a link until it succeeds, spinning at first and
+ * then sleeping until the other stage wakes us
+ * @param link link the operation uses
+ * @param attempt push or pop that returns true once it has succeeded
+ * @param stats receives the time spent waiting
+ */
+template <typename Attempt>
+static void WaitFor(BatchLink& link, Attempt attempt, StageStats& stats) {
+    Clock::time_point start = Clock::now();
+
+    for (unsigned spins = 0; spins < SpinLimit; spins ++) {
+        if (attempt()) {
+            stats.waiting += Clock::now() - start;
+            return;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(link.mutex);
+    link.sleepers.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!attempt()) {
+        link.wake.wait(lock);
+    }
+    link.sleepers.fetch_sub(1);
+    stats.waiting += Clock::now() - start;
+}
+
+/**
+ * Move a batch into a link, waiting while its queue is full
+ * @param link link the calling thread produces into
+ * @param batch batch to add, ownership passes to the queue
+ * @param stats receives the time spent waiting
+ */
+static void Push(BatchLink& link, BatchPtr&& batch, StageStats& stats) {
+    if (!link.queue.TryPush(std::move(batch))) {
+        WaitFor(link, [&]() { return link.queue.TryPush(std::move(batch)); }, stats);
+    }
+    Wake(link);
+}
+
+/**
+ * Take the next batch from a link, waiting while its queue is empty
+ * @param link link the calling thread consumes from
+ * @param stats receives the time spent waiting and the queue length
+ * @return the batch, null at the end of the input
+ */
+static BatchPtr Pop(BatchLink& link, StageStats& stats) {
+    BatchPtr batch;
+
+    stats.queued += link.queue.Size();
+    stats.pops ++;
+    if (!link.queue.TryPop(batch)) {
+        WaitFor(link, [&]() { return link.queue.TryPop(batch); }, stats);
+    }
+    Wake(link);
+    return batch;
+}
+
+/**
+ * Reader stage: fill recycled batches with the non-comment lines of the input.
+ * A batch is sent on when it is full, or early when no more input is
+ * buffered, so lines typed at a terminal are not held back.
+ * @param is stream of postfix expressions
+ * @param recycled link from the writer, carrying batches it is done with
+ * @param read link to the tokenizer
+ * @param stats receives the reader's statistics
+ */
+static void ReadStage(istream& is, BatchLink& recycled, BatchLink& read, StageStats& stats) {
+    bool fMore = true;
+
+    while (fMore) {
+        BatchPtr batch = Pop(recycled, stats);
+
+        batch->count = 0;
+        while (batch->count < BatchSize) {
+            string& line = batch->lines[batch->count];
+
+            if (!getline(is, line)) {
+                fMore = false;
+                break;
+            }
+            if (line.length() > 0 && line[0] != '#') {
+                batch->count ++;
+                if (is.rdbuf()->in_avail() <= 0) {
+                    break;
+                }
+            }
+        }
+        // A batch only comes up empty at the end of the input, when it is no longer needed
+        if (batch->count > 0) {
+            Push(read, std::move(batch), stats);
+        }
+    }
+    Push(read, BatchPtr(), stats);
+}
+
+/**
+ * Tokenizer stage: split each line of a batch into its tokens
+ * @param read link from the reader
+ * @param tokenized link to the simplifier
+ * @param stats receives the tokenizer's statistics
+ */
+static void TokenizeStage(BatchLink& read, BatchLink& tokenized, StageStats& stats) {
+    for (BatchPtr batch = Pop(read, stats); batch != nullptr; batch = Pop(read, stats)) {
+        if (batch->tokens.size() < batch->count) {
+            batch->tokens.resize(batch->count);
+        }
+        for (size_t i = 0; i < batch->count; i ++) {
+            ExpressionTree::Tokenize(batch->lines[i], batch->tokens[i]);
+        }
+        Push(tokenized, std::move(batch), stats);
+    }
+    Push(tokenized, BatchPtr(), stats);
+}
+
+/**
+ * Simplifier stage: replace the trees of each batch with the simplified
+ * trees of its lines.  A line that is not valid postfix leaves its tree
+ * empty; the error is reported by the writer so it stays in order.
+ * @param tokenized link from the tokenizer
+ * @param simplified link to the writer
+ * @param fExpand whether to multiply out products after simplifying
+ * @param fHorner whether to rewrite polynomials in Horner form after simplifying
+ * @param fRebalance whether to rebalance + and * chains after simplifying
+ * @param stats receives the simplifier's statistics
+ */
+static void SimplifyStage(BatchLink& tokenized, BatchLink& simplified, bool fExpand, bool fHorner, bool fRebalance, StageStats& stats) {
+    for (BatchPtr batch = Pop(tokenized, stats); batch != nullptr; batch = Pop(tokenized, stats)) {
+        // Release the previous trees here, so their nodes are reused by this thread
+        batch->trees.clear();
+        batch->trees.resize(batch->count);
+        for (size_t i = 0; i < batch->count; i ++) {
+            ExpressionTree& expTree = batch->trees[i];
+
+            expTree.SetSimplifyOnBuild(true);
+            expTree.SetReportErrors(false);
+            if (expTree.BuildExpressionTree(batch->tokens[i])) {
+                if (fExpand) {
+                    expTree.Expand();
+                }
+                if (fHorner) {
+                    expTree.Horner();
+                }
+                if (fRebalance) {
+                    expTree.Rebalance();
+                }
+            }
+        }
+        Push(simplified, std::move(batch), stats);
+    }
+    Push(simplified, BatchPtr(), stats);
+}
+
+/**
+ * Write one stage's statistics
+ * @param os receives the statistics
+ * @param name name of the stage
+ * @param stats the stage's statistics
+ * @param elapsed running time of the whole pipeline
+ * @param queue name of the queue the stage takes work from
+ */
+static void WriteStageStats(ostream& os, const char* name, const StageStats& stats, Clock::duration elapsed, const char* queue) {
+    double busy = elapsed.count() > 0 ? 100.0 * (1.0 - (double) stats.waiting.count() / elapsed.count()) : 0;
+
+    os << std::left << std::setw(11) << name << std::right << std::setw(6) << busy << "% busy, "
+       << queue << " queue holds " << (stats.pops > 0 ? (double) stats.queued / stats.pops : 0)
+       << " of " << BatchCount << " batches on average" << endl;
+}
+
+/**
+ * Read postfix expressions, one per line, and write each simplified
+ * expression on its own line in the requested format, with reading,
+ * tokenizing, simplifying, and writing running concurrently.  The output is
+ * the same as processing the lines one at a time: invalid lines produce
+ * Error, and comment lines are skipped.
+ * @param is stream of postfix expressions
+ * @param os receives the simplified expressions
+ * @param format output format
+ * @param fExpand whether to multiply out products after simplifying
+ * @param fHorner whether to rewrite polynomials in Horner form after simplifying
+ * @param fRebalance whether to rebalance + and * chains after simplifying
+ * @param fStats whether to write throughput and stage occupancy to cerr
+ * @return exit status
+ */
+int RunPipeline(istream& is, ostream& os, OutputFormat format, bool fExpand, bool fHorner, bool fRebalance, bool fStats) {
+    BatchLink recycled;
+    BatchLink read;
+    BatchLink tokenized;
+    BatchLink simplified;
+    StageStats readStats;
+    StageStats tokenizeStats;
+    StageStats simplifyStats;
+    StageStats writeStats;
+    OutputSink sink(os);
+    size_t expressions = 0;
+
+    for (size_t i = 0; i < BatchCount; i ++) {
+        BatchPtr batch(new PipelineBatch());
+
+        batch->lines.resize(BatchSize);
+        recycled.queue.TryPush(std::move(batch));
+    }
+
+    // Reading must not flush the output from the reader thread; the writer flushes each batch
+    is.tie(nullptr);
+
+    Clock::time_point start = Clock::now();
+    std::thread reader(ReadStage, std::ref(is), std::ref(recycled), std::ref(read), std::ref(readStats));
+    std::thread tokenizer(TokenizeStage, std::ref(read), std::ref(tokenized), std::ref(tokenizeStats));
+    std::thread simplifier(SimplifyStage, std::ref(tokenized), std::ref(simplified), fExpand, fHorner, fRebalance, std::ref(simplifyStats));
+
+    for (BatchPtr batch = Pop(simplified, writeStats); batch != nullptr; batch = Pop(simplified, writeStats)) {
+        for (size_t i = 0; i < batch->count; i ++) {
+            if (batch->trees[i].Root() == nullptr) {
+                sink.Write("Error\n");
+            } else {
+                batch->trees[i].Write(sink, format);
+                sink.Put('\n');
+            }
+        }
+        expressions += batch->count;
+        sink.Flush();
+        Push(recycled, std::move(batch), writeStats);
+    }
+
+    simplifier.join();
+    tokenizer.join();
+    reader.join();
+    Clock::duration elapsed = Clock::now() - start;
+
+    if (fStats) {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+
+        cerr << std::fixed << std::setprecision(1);
+        cerr << expressions << " expressions in " << std::setprecision(3) << seconds << " s, "
+                  << std::setprecision(0) << (seconds > 0 ? expressions / seconds : 0) << " expressions/s" << endl;
+        cerr << std::setprecision(1);
+        WriteStageStats(cerr, "reader", readStats, elapsed, "recycled");
+        WriteStageStats(cerr, "tokenizer", tokenizeStats, elapsed, "read");
+        WriteStageStats(cerr, "simplifier", simplifyStats, elapsed, "tokenized");
+        WriteStageStats(cerr, "writer", writeStats, elapsed, "simplified");
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+//
+// Pipelined simplification of a stream of postfix expressions
+// Author: Max Benson
+// Date: 02/07/2022
+//
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <iostream>
+#include "TreeEmitter.h"
+using std::istream;
+using std::ostream;
+
+int RunPipeline(istream& is, ostream& os, OutputFormat format, bool fExpand, bool fHorner, bool fRebalance, bool fStats);
+
+#endif //PIPELINE_H
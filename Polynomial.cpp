@@ -0,0 +1,753 @@
+//
+// Implements the Polynomial Class
+// Author: Max Benson
+// Date: 01/24/2022
+//
+
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include "InternTable.h"
+#include "Polynomial.h"
+
+// Below this many coefficients Karatsuba falls back to schoolbook multiplication
+static const size_t KaratsubaThreshold = 32;
+
+/**
+ * Add steps to the work done by a conversion
+ * @param work steps taken so far, updated
+ * @param steps steps to add
+ * @return true if the total is still within Polynomial::MaxWork
+ */
+static bool Spend(size_t& work, size_t steps) {
+    work += steps;
+    return work <= Polynomial::MaxWork;
+}
+
+/**
+ * Coefficient multiplications MultiplyDense makes for operands with na and
+ * nb coefficients: na*nb by schoolbook, 3 half size products per Karatsuba
+ * level above the threshold
+ */
+static size_t DenseWork(size_t na, size_t nb) {
+    size_t n = std::max(na, nb);
+    size_t products = 1;
+
+    if (std::min(na, nb) <= KaratsubaThreshold) {
+        return na * nb;
+    }
+    while (n > KaratsubaThreshold) {
+        n = (n + 1) / 2;
+        products *= 3;
+    }
+    return products * n * n;
+}
+
+/**
+ * Adds the product of a[0..na) and b[0..nb) into result[0..na+nb-1) by
+ * schoolbook multiplication
+ */
+static void MultiplySchoolbook(const uint32_t* a, size_t na, const uint32_t* b, size_t nb, uint32_t* result) {
+    for (size_t i = 0; i < na; i ++) {
+        if (a[i] == 0) {
+            continue;
+        }
+        for (size_t j = 0; j < nb; j ++) {
+            result[i + j] += a[i] * b[j];
+        }
+    }
+}
+
+/**
+ * Adds the product of a[0..n) and b[0..n) into result[0..2n-1) using
+ * Karatsuba's three half size products
+ */
+static void MultiplyKaratsuba(const uint32_t* a, const uint32_t* b, size_t n, uint32_t* result) {
+    if (n <= KaratsubaThreshold) {
+        MultiplySchoolbook(a, n, b, n, result);
+        return;
+    }
+
+    size_t low = n / 2;
+    size_t high = n - low;
+    std::vector<uint32_t> z0(2*low - 1, 0);
+    std::vector<uint32_t> z1(2*high - 1, 0);
+    std::vector<uint32_t> z2(2*high - 1, 0);
+    std::vector<uint32_t> sumA(high);
+    std::vector<uint32_t> sumB(high);
+
+    for (size_t i = 0; i < high; i ++) {
+        sumA[i] = a[low + i] + (i < low ? a[i] : 0);
+        sumB[i] = b[low + i] + (i < low ? b[i] : 0);
+    }
+    MultiplyKaratsuba(a, b, low, z0.data());
+    MultiplyKaratsuba(a + low, b + low, high, z2.data());
+    MultiplyKaratsuba(sumA.data(), sumB.data(), high, z1.data());
+
+    for (size_t i = 0; i < z0.size(); i ++) {
+        z1[i] -= z0[i];
+        result[i] += z0[i];
+    }
+    for (size_t i = 0; i < z2.size(); i ++) {
+        z1[i] -= z2[i];
+        result[2*low + i] += z2[i];
+    }
+    for (size_t i = 0; i < z1.size(); i ++) {
+        result[low + i] += z1[i];
+    }
+}
+
+/**
+ * Constant polynomial
+ * @param value the constant
+ * @return polynomial
+ */
+Polynomial Polynomial::Constant(uint32_t value) {
+    Polynomial polynomial;
+
+    polynomial.AddTerm(Monomial(), value);
+    return polynomial;
+}
+
+/**
+ * Polynomial consisting of a single variable
+ * @param symbol SymbolTable id of the variable
+ * @return polynomial
+ */
+Polynomial Polynomial::Variable(uint32_t symbol) {
+    Polynomial polynomial;
+
+    polynomial.AddTerm(Monomial(1, std::make_pair(symbol, 1u)), 1);
+    return polynomial;
+}
+
+/**
+ * Convert an expression tree to a polynomial.  Chains of * are flattened
+ * and their factors multiplied pairwise, smallest first.  The tree is
+ * walked without recursion, converting children before their parents.
+ * @param tree expression tree
+ * @param result receives the polynomial
+ * @param failed if not null, subtrees known not to convert, which are
+ * rejected without a look; when the conversion fails the subtree that
+ * failed and every subtree containing it are added, so a caller trying
+ * smaller and smaller subtrees converts each node only a bounded number of
+ * times
+ * @return true if successful, false if the tree divides, raises to a power
+ * that is not a non-negative number, or expands past one of the bounds,
+ * MaxWork counting the steps of the whole conversion
+ */
+bool Polynomial::FromTree(const TreeNode* tree, Polynomial& result, std::unordered_set<const TreeNode*>* failed) {
+    struct Frame {
+        const TreeNode* node;
+        bool fExpanded;
+        bool fChainInner;   // a * below a *, its factors belong to the chain above
+        size_t values;      // size of the value stack when the node was expanded
+    };
+    std::vector<Frame> pending(1, Frame{tree, false, false, 0});
+    std::vector<Polynomial> values;
+    size_t work = 0;
+
+    while (!pending.empty()) {
+        Frame& frame = pending.back();
+        const TreeNode* node = frame.node;
+        bool fFailed = false;
+
+        if (node->Type() == NumberOperand) {
+            values.push_back(Constant((uint32_t) atoi(node->Data().c_str())));
+            pending.pop_back();
+        } else if (node->Type() == VariableOperand) {
+            const string& name = node->Data();
+            if (name.length() > 1 && name[0] == '-') {
+                // Simplification writes 0 - x as the variable -x
+                values.push_back(Constant(0).Subtract(Variable(SymbolTable::Current().Intern(name.substr(1)))));
+            } else {
+                values.push_back(Variable(node->Symbol()));
+            }
+            pending.pop_back();
+        } else if (!frame.fExpanded) {
+            if (failed != nullptr && failed->count(node) != 0) {
+                fFailed = true;
+            } else if (node->Data() == "^") {
+                // Only a constant, non-negative exponent gives a polynomial
+                if (!node->Right()->IsNumber() || atoi(node->Right()->Data().c_str()) < 0) {
+                    fFailed = true;
+                } else {
+                    frame.fExpanded = true;
+                    frame.values = values.size();
+                    pending.push_back(Frame{node->Left(), false, false, 0});
+                }
+            } else if (node->Data() == "+" || node->Data() == "-" || node->Data() == "*") {
+                bool fChain = node->Data() == "*";
+                const TreeNode* left = node->Left();
+                const TreeNode* right = node->Right();
+
+                frame.fExpanded = true;
+                frame.values = values.size();
+                pending.push_back(Frame{right, false, fChain && right->Type() == Operator && right->Data() == "*", 0});
+                pending.push_back(Frame{left, false, fChain && left->Type() == Operator && left->Data() == "*", 0});
+            } else {
+                fFailed = true;
+            }
+        } else if (frame.fChainInner) {
+            pending.pop_back();
+        } else if (node->Data() == "+" || node->Data() == "-") {
+            // Add the smaller side into the larger in place, so a long chain of sums stays linear
+            uint32_t sign = node->Data() == "+" ? 1u : 0u - 1u;
+            Polynomial right = std::move(values.back());
+            values.pop_back();
+            Polynomial& left = values.back();
+            if (!Spend(work, std::min(left.TermCount(), right.TermCount()))) {
+                fFailed = true;
+            } else if (left.TermCount() >= right.TermCount()) {
+                for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = right._terms.begin(); it != right._terms.end(); ++it) {
+                    left.AddTerm(it->first, sign * it->second);
+                }
+            } else {
+                for (std::unordered_map<Monomial, uint32_t, MonomialHash>::iterator it = right._terms.begin(); it != right._terms.end(); ++it) {
+                    it->second *= sign;
+                }
+                for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = left._terms.begin(); it != left._terms.end(); ++it) {
+                    right.AddTerm(it->first, it->second);
+                }
+                left = std::move(right);
+            }
+            fFailed = fFailed || left.TermCount() > MaxTerms;
+            pending.pop_back();
+        } else if (node->Data() == "^") {
+            Polynomial power;
+            fFailed = !values.back().Power((uint32_t) atoi(node->Right()->Data().c_str()), power, &work);
+            values.back() = std::move(power);
+            pending.pop_back();
+        } else {
+            // Multiply the factors of the whole * chain, neighbors pairwise so factors grow evenly
+            std::deque<Polynomial> factors(std::make_move_iterator(values.begin() + frame.values), std::make_move_iterator(values.end()));
+            values.resize(frame.values);
+            while (factors.size() > 1 && !fFailed) {
+                Polynomial a = std::move(factors.front());
+                factors.pop_front();
+                Polynomial b = std::move(factors.front());
+                factors.pop_front();
+                Polynomial product;
+                fFailed = !a.Multiply(b, product, &work);
+                factors.push_back(std::move(product));
+            }
+            values.push_back(std::move(factors.front()));
+            pending.pop_back();
+        }
+
+        if (fFailed) {
+            // The node that failed is either on top or was just popped; every expanded frame contains it
+            if (failed != nullptr) {
+                failed->insert(node);
+                for (size_t i = 0; i < pending.size(); i ++) {
+                    if (pending[i].fExpanded) {
+                        failed->insert(pending[i].node);
+                    }
+                }
+            }
+            return false;
+        }
+    }
+    result = std::move(values.back());
+    return true;
+}
+
+/**
+ * Build the expanded tree of the polynomial.  Terms are ordered by
+ * decreasing degree, then by variable name, and each term is written as its
+ * coefficient times powers of its variables, so equal polynomials give equal
+ * trees.
+ * @return new tree, owned by the caller
+ */
+TreeNode* Polynomial::ToTree() const {
+    typedef std::vector<std::pair<string, uint32_t> > NamedMonomial;
+    struct Term {
+        NamedMonomial variables;
+        uint32_t degree;
+        int32_t coefficient;
+    };
+    SymbolTable& symbols = SymbolTable::Current();
+    std::vector<Term> terms;
+
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = _terms.begin(); it != _terms.end(); ++it) {
+        Term term;
+        term.degree = 0;
+        term.coefficient = (int32_t) it->second;
+        for (size_t i = 0; i < it->first.size(); i ++) {
+            term.variables.push_back(std::make_pair(symbols.Name(it->first[i].first), it->first[i].second));
+            term.degree += it->first[i].second;
+        }
+        std::sort(term.variables.begin(), term.variables.end());
+        terms.push_back(term);
+    }
+    std::sort(terms.begin(), terms.end(), [](const Term& term1, const Term& term2) {
+        if (term1.degree != term2.degree) {
+            return term1.degree > term2.degree;
+        }
+        // Same degree: the term with more of the alphabetically first variable leads
+        for (size_t i = 0; i < term1.variables.size() && i < term2.variables.size(); i ++) {
+            if (term1.variables[i].first != term2.variables[i].first) {
+                return term1.variables[i].first < term2.variables[i].first;
+            }
+            if (term1.variables[i].second != term2.variables[i].second) {
+                return term1.variables[i].second > term2.variables[i].second;
+            }
+        }
+        return term1.variables.size() < term2.variables.size();
+    });
+
+    if (terms.empty()) {
+        return new TreeNode(NumberOperand, "0");
+    }
+
+    TreeNode* sum = nullptr;
+    for (size_t t = 0; t < terms.size(); t ++) {
+        const Term& term = terms[t];
+        // After the first term a negative coefficient is written as a subtraction
+        bool fSubtract = sum != nullptr && term.coefficient < 0;
+        int64_t magnitude = fSubtract ? -(int64_t) term.coefficient : term.coefficient;
+        TreeNode* product = nullptr;
+
+        if (magnitude != 1 || term.variables.empty()) {
+            product = new TreeNode(NumberOperand, to_string(magnitude));
+        }
+        for (size_t v = 0; v < term.variables.size(); v ++) {
+            TreeNode* factor = new TreeNode(VariableOperand, term.variables[v].first);
+            if (term.variables[v].second > 1) {
+                TreeNode* power = new TreeNode(Operator, "^");
+                power->SetLeft(factor);
+                power->SetRight(new TreeNode(NumberOperand, to_string(term.variables[v].second)));
+                factor = power;
+            }
+            if (product == nullptr) {
+                product = factor;
+            } else {
+                TreeNode* times = new TreeNode(Operator, "*");
+                times->SetLeft(product);
+                times->SetRight(factor);
+                product = times;
+            }
+        }
+
+        if (sum == nullptr) {
+            sum = product;
+        } else {
+            TreeNode* plus = new TreeNode(Operator, fSubtract ? "-" : "+");
+            plus->SetLeft(sum);
+            plus->SetRight(product);
+            sum = plus;
+        }
+    }
+    return sum;
+}
+
+/**
+ * Build base ^ exponent for a variable, or just the variable when the exponent is 1
+ * @param symbol SymbolTable id of the variable
+ * @param exponent positive exponent
+ * @return new tree, owned by the caller
+ */
+static TreeNode* VariablePower(uint32_t symbol, uint32_t exponent) {
+    TreeNode* variable = new TreeNode(VariableOperand, SymbolTable::Current().Name(symbol));
+
+    if (exponent == 1) {
+        return variable;
+    }
+
+    TreeNode* power = new TreeNode(Operator, "^");
+    power->SetLeft(variable);
+    power->SetRight(new TreeNode(NumberOperand, to_string(exponent)));
+    return power;
+}
+
+/**
+ * Build the Horner form of a list of terms.  The variable occurring in the
+ * most terms, v, is factored out of the terms containing it as v^d, d being
+ * its smallest exponent among them, giving v^d * Q + R where Q and R are
+ * put in Horner form in turn.  Ties go to the alphabetically first variable.
+ * The terms are split in place, Q's moved to the front of their range and
+ * divided by v^d, and the ranges are worked through without recursion.
+ * @param terms terms of the polynomial, like terms already combined; they
+ * are reordered and changed
+ * @return new tree, owned by the caller, nullptr if it would take more than
+ * Polynomial::MaxWork steps
+ */
+static TreeNode* BuildHorner(std::vector<std::pair<Polynomial::Monomial, uint32_t> >& terms) {
+    typedef std::pair<Polynomial::Monomial, uint32_t> Term;
+    struct Frame {
+        size_t begin;
+        size_t middle;      // Q is [begin, middle) and R is [middle, end) once split
+        size_t end;
+        uint32_t best;      // NoInternId until the range is split
+        uint32_t exponent;
+    };
+    SymbolTable& symbols = SymbolTable::Current();
+    std::vector<Frame> pending(1, Frame{0, 0, terms.size(), NoInternId, 0});
+    std::vector<TreeNode*> results;
+    size_t work = 0;
+
+    while (!pending.empty()) {
+        Frame& frame = pending.back();
+
+        if (frame.best == NoInternId) {
+            std::unordered_map<uint32_t, size_t> counts;
+            uint32_t best = NoInternId;
+
+            if (!Spend(work, frame.end - frame.begin)) {
+                for (size_t i = 0; i < results.size(); i ++) {
+                    TreeNode::Release(results[i]);
+                }
+                return nullptr;
+            }
+            for (size_t t = frame.begin; t < frame.end; t ++) {
+                for (size_t i = 0; i < terms[t].first.size(); i ++) {
+                    counts[terms[t].first[i].first]++;
+                }
+            }
+            for (std::unordered_map<uint32_t, size_t>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+                if (best == NoInternId || it->second > counts[best] ||
+                    (it->second == counts[best] && symbols.Name(it->first) < symbols.Name(best))) {
+                    best = it->first;
+                }
+            }
+            if (best == NoInternId) {
+                // At most the constant term is left
+                results.push_back(new TreeNode(NumberOperand, to_string(frame.begin == frame.end ? 0 : (int32_t) terms[frame.begin].second)));
+                pending.pop_back();
+                continue;
+            }
+
+            // Move the terms containing best to the front and divide them by best^exponent
+            std::vector<Term>::iterator middle = std::partition(terms.begin() + frame.begin, terms.begin() + frame.end, [best](const Term& term) {
+                for (size_t i = 0; i < term.first.size(); i ++) {
+                    if (term.first[i].first == best) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+            uint32_t exponent = 0;
+            for (std::vector<Term>::iterator t = terms.begin() + frame.begin; t != middle; ++t) {
+                for (size_t i = 0; i < t->first.size(); i ++) {
+                    if (t->first[i].first == best && (exponent == 0 || t->first[i].second < exponent)) {
+                        exponent = t->first[i].second;
+                    }
+                }
+            }
+            for (std::vector<Term>::iterator t = terms.begin() + frame.begin; t != middle; ++t) {
+                for (size_t i = 0; i < t->first.size(); i ++) {
+                    if (t->first[i].first == best) {
+                        t->first[i].second -= exponent;
+                        if (t->first[i].second == 0) {
+                            t->first.erase(t->first.begin() + i);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            frame.best = best;
+            frame.exponent = exponent;
+            frame.middle = middle - terms.begin();
+            Frame quotient = {frame.begin, 0, frame.middle, NoInternId, 0};
+            Frame remainder = {frame.middle, 0, frame.end, NoInternId, 0};
+            if (remainder.begin < remainder.end) {
+                pending.push_back(remainder);
+            }
+            pending.push_back(quotient);
+            continue;
+        }
+
+        // Q and, if there is one, R are built; join them as v^d * Q + R
+        TreeNode* rest = nullptr;
+        if (frame.middle < frame.end) {
+            rest = results.back();
+            results.pop_back();
+        }
+        TreeNode* factor = results.back();
+        results.pop_back();
+
+        TreeNode* product = VariablePower(frame.best, frame.exponent);
+        if (factor->IsOne()) {
+            TreeNode::Release(factor);
+        } else {
+            TreeNode* times = new TreeNode(Operator, "*");
+            times->SetLeft(factor);
+            times->SetRight(product);
+            product = times;
+        }
+        pending.pop_back();
+        if (rest == nullptr) {
+            results.push_back(product);
+            continue;
+        }
+
+        TreeNode* sum;
+        if (rest->IsNumber() && rest->Data()[0] == '-' && rest->Data() != "-2147483648") {
+            sum = new TreeNode(Operator, "-");
+            sum->SetRight(new TreeNode(NumberOperand, rest->Data().substr(1)));
+            TreeNode::Release(rest);
+        } else {
+            sum = new TreeNode(Operator, "+");
+            sum->SetRight(rest);
+        }
+        sum->SetLeft(product);
+        results.push_back(sum);
+    }
+    return results.back();
+}
+
+/**
+ * Build the polynomial as a tree in multivariate Horner form, which needs
+ * far fewer multiplications to evaluate than the expanded sum of terms.
+ * For one variable 3x^3 + 2x^2 + x + 7 becomes ((3*x+2)*x+1)*x+7.
+ * @return new tree, owned by the caller, nullptr if building it would take
+ * more than MaxWork steps
+ */
+TreeNode* Polynomial::ToHornerTree() const {
+    std::vector<std::pair<Monomial, uint32_t> > terms(_terms.begin(), _terms.end());
+
+    return BuildHorner(terms);
+}
+
+/**
+ * Sum of two polynomials
+ * @param other polynomial to add
+ * @return this + other
+ */
+Polynomial Polynomial::Add(const Polynomial& other) const {
+    Polynomial sum = *this;
+
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = other._terms.begin(); it != other._terms.end(); ++it) {
+        sum.AddTerm(it->first, it->second);
+    }
+    return sum;
+}
+
+/**
+ * Difference of two polynomials
+ * @param other polynomial to subtract
+ * @return this - other
+ */
+Polynomial Polynomial::Subtract(const Polynomial& other) const {
+    Polynomial difference = *this;
+
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = other._terms.begin(); it != other._terms.end(); ++it) {
+        difference.AddTerm(it->first, 0u - it->second);
+    }
+    return difference;
+}
+
+/**
+ * Largest total degree of a term
+ * @return degree, 0 for a constant or zero polynomial
+ */
+uint32_t Polynomial::Degree() const {
+    uint32_t degree = 0;
+
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = _terms.begin(); it != _terms.end(); ++it) {
+        uint32_t termDegree = 0;
+        for (size_t i = 0; i < it->first.size(); i ++) {
+            termDegree += it->first[i].second;
+        }
+        degree = std::max(degree, termDegree);
+    }
+    return degree;
+}
+
+/**
+ * Product of two polynomials, dense Karatsuba when both are in the same
+ * single variable, sparse otherwise
+ * @param other polynomial to multiply by
+ * @param result receives this * other
+ * @param work if not null, steps taken so far by the conversion, see
+ * MaxWork; the product's steps are added
+ * @return true if successful, false if the product would pass a bound
+ */
+bool Polynomial::Multiply(const Polynomial& other, Polynomial& result, size_t* work) const {
+    uint32_t symbol1;
+    uint32_t symbol2;
+
+    if ((uint64_t) Degree() + other.Degree() > MaxDegree) {
+        return false;
+    }
+    if (IsUnivariate(symbol1) && other.IsUnivariate(symbol2) &&
+        (symbol1 == symbol2 || symbol1 == NoInternId || symbol2 == NoInternId)) {
+        // At most MaxDegree + 1 terms, so no other bound can be passed
+        if (work != nullptr && !Spend(*work, DenseWork(Degree() + 1, other.Degree() + 1) / 64 + 1)) {
+            return false;
+        }
+        result = MultiplyDense(other, symbol1 != NoInternId ? symbol1 : symbol2);
+        return true;
+    }
+    if ((uint64_t) _terms.size() * other._terms.size() > MaxProductWork) {
+        return false;
+    }
+    if (work != nullptr && !Spend(*work, _terms.size() * other._terms.size())) {
+        return false;
+    }
+    result = MultiplySparse(other);
+    return result.TermCount() <= MaxTerms;
+}
+
+/**
+ * Power of a polynomial by repeated squaring
+ * @param exponent non-negative power
+ * @param result receives this ^ exponent
+ * @param work if not null, steps taken so far by the conversion, see
+ * MaxWork; the steps of every product are added
+ * @return true if successful, false if the power would pass a bound
+ */
+bool Polynomial::Power(uint32_t exponent, Polynomial& result, size_t* work) const {
+    Polynomial power = Constant(1);
+    Polynomial square = *this;
+
+    if (exponent != 0 && (uint64_t) Degree() * exponent > MaxDegree) {
+        return false;
+    }
+    while (exponent != 0) {
+        if (exponent & 1 && !power.Multiply(square, power, work)) {
+            return false;
+        }
+        exponent >>= 1;
+        if (exponent != 0 && !square.Multiply(square, square, work)) {
+            return false;
+        }
+    }
+    result = power;
+    return true;
+}
+
+/**
+ * Check whether every term uses at most one variable, the same one
+ * @param symbol receives the variable, NoInternId for a constant polynomial
+ * @return true if univariate or constant
+ */
+bool Polynomial::IsUnivariate(uint32_t& symbol) const {
+    symbol = NoInternId;
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = _terms.begin(); it != _terms.end(); ++it) {
+        if (it->first.size() > 1) {
+            return false;
+        }
+        if (it->first.size() == 1) {
+            if (symbol != NoInternId && symbol != it->first[0].first) {
+                return false;
+            }
+            symbol = it->first[0].first;
+        }
+    }
+    return true;
+}
+
+/**
+ * Product of two polynomials in the same variable by dense multiplication
+ * @param other polynomial to multiply by
+ * @param symbol the variable, NoInternId if both are constants
+ * @return this * other
+ */
+Polynomial Polynomial::MultiplyDense(const Polynomial& other, uint32_t symbol) const {
+    const Polynomial* factors[2] = {this, &other};
+    std::vector<uint32_t> dense[2];
+
+    for (size_t f = 0; f < 2; f ++) {
+        for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator it = factors[f]->_terms.begin(); it != factors[f]->_terms.end(); ++it) {
+            uint32_t exponent = it->first.empty() ? 0 : it->first[0].second;
+            if (dense[f].size() <= exponent) {
+                dense[f].resize(exponent + 1, 0);
+            }
+            dense[f][exponent] = it->second;
+        }
+    }
+
+    Polynomial product;
+    if (dense[0].empty() || dense[1].empty()) {
+        return product;
+    }
+
+    std::vector<uint32_t> result(dense[0].size() + dense[1].size() - 1, 0);
+    size_t shorter = std::min(dense[0].size(), dense[1].size());
+    if (shorter <= KaratsubaThreshold) {
+        MultiplySchoolbook(dense[0].data(), dense[0].size(), dense[1].data(), dense[1].size(), result.data());
+    } else {
+        size_t n = std::max(dense[0].size(), dense[1].size());
+        dense[0].resize(n, 0);
+        dense[1].resize(n, 0);
+        result.resize(2*n - 1, 0);
+        MultiplyKaratsuba(dense[0].data(), dense[1].data(), n, result.data());
+    }
+
+    for (size_t e = 0; e < result.size(); e ++) {
+        if (result[e] != 0) {
+            product.AddTerm(e == 0 ? Monomial() : Monomial(1, std::make_pair(symbol, (uint32_t) e)), result[e]);
+        }
+    }
+    return product;
+}
+
+/**
+ * Product of two polynomials term by term, collecting like terms in a hash table
+ * @param other polynomial to multiply by
+ * @return this * other
+ */
+Polynomial Polynomial::MultiplySparse(const Polynomial& other) const {
+    Polynomial product;
+
+    product._terms.reserve(_terms.size() * other._terms.size());
+    for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator a = _terms.begin(); a != _terms.end(); ++a) {
+        for (std::unordered_map<Monomial, uint32_t, MonomialHash>::const_iterator b = other._terms.begin(); b != other._terms.end(); ++b) {
+            // Merge the two sorted variable lists, adding exponents of shared variables
+            Monomial monomial;
+            size_t i = 0;
+            size_t j = 0;
+
+            while (i < a->first.size() || j < b->first.size()) {
+                if (j == b->first.size() || (i < a->first.size() && a->first[i].first < b->first[j].first)) {
+                    monomial.push_back(a->first[i++]);
+                } else if (i == a->first.size() || b->first[j].first < a->first[i].first) {
+                    monomial.push_back(b->first[j++]);
+                } else {
+                    monomial.push_back(std::make_pair(a->first[i].first, a->first[i].second + b->first[j].second));
+                    i++;
+                    j++;
+                }
+            }
+            product.AddTerm(monomial, a->second * b->second);
+        }
+    }
+    return product;
+}
+
+/**
+ * Add coefficient * monomial, dropping the term if its coefficient becomes 0
+ * @param monomial variables and exponents of the term
+ * @param coefficient amount to add
+ */
+void Polynomial::AddTerm(const Monomial& monomial, uint32_t coefficient) {
+    if (coefficient == 0) {
+        return;
+    }
+
+    std::pair<std::unordered_map<Monomial, uint32_t, MonomialHash>::iterator, bool> inserted = _terms.emplace(monomial, coefficient);
+    if (!inserted.second) {
+        inserted.first->second += coefficient;
+        if (inserted.first->second == 0) {
+            _terms.erase(inserted.first);
+        }
+    }
+}
+
+/**
+ * Hash of a monomial
+ * @param monomial variables and exponents
+ * @return hash value
+ */
+size_t Polynomial::MonomialHash::operator()(const Monomial& monomial) const {
+    uint64_t h = 0x84222325CBF29CE4ULL;
+
+    for (size_t i = 0; i < monomial.size(); i ++) {
+        h = (h ^ monomial[i].first) * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ monomial[i].second) * 0x9E3779B97F4A7C15ULL;
+    }
+    return (size_t) (h ^ (h >> 29));
+}
@@ -0,0 +1,77 @@
+//
+// Interface Definition for the Polynomial Class
+// Author: Max Benson
+// Date: 01/24/2022
+//
+// Sparse multivariate polynomial with integer coefficients, used to expand
+// products.  Coefficients wrap modulo 2^32, the same integer arithmetic
+// ExpressionProgram evaluates with, so an expanded tree always evaluates to
+// the same value as the tree it came from.
+//
+// Products of two polynomials in the same single variable are computed
+// densely with Karatsuba multiplication; other products multiply term by
+// term into a hash table.  Chains of * are multiplied as a balanced product
+// tree so the factors being multiplied stay similar in size.
+//
+// Expansion can grow without limit, as in (x^65536)^65536 or (x+y)^65536,
+// so polynomials are bounded: no term may have a total degree above
+// MaxDegree, no polynomial more than MaxTerms terms, and no sparse product
+// more than MaxProductWork term multiplications.  Each whole conversion,
+// FromTree or ToHornerTree, is also limited to MaxWork steps in total, so
+// a long chain of small operations can't take quadratic time either.  A
+// step is a term added or multiplied, or a term visited while building
+// Horner form; dense coefficient multiplications are so much cheaper that
+// 64 of them count as one step.  Operations that would pass a bound fail
+// instead.
+//
+#ifndef POLYNOMIAL_H
+#define POLYNOMIAL_H
+
+#include <stdint.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "TreeNode.h"
+
+class Polynomial {
+public:
+    // Variables and their exponents, sorted by SymbolTable id
+    typedef std::vector<std::pair<uint32_t, uint32_t> > Monomial;
+
+    // Largest total degree of a term, also the largest power SimplifyTree folds
+    static const uint32_t MaxDegree = 1 << 16;
+    static const size_t MaxTerms = 1 << 16;
+    static const size_t MaxProductWork = 1 << 20;
+    static const size_t MaxWork = 1 << 22;
+
+    Polynomial() {};
+
+    static Polynomial Constant(uint32_t value);
+    static Polynomial Variable(uint32_t symbol);
+    static bool FromTree(const TreeNode* tree, Polynomial& result, std::unordered_set<const TreeNode*>* failed = nullptr);
+
+    TreeNode* ToTree() const;
+    TreeNode* ToHornerTree() const;
+    size_t TermCount() const { return _terms.size(); };
+    uint32_t Degree() const;
+
+    Polynomial Add(const Polynomial& other) const;
+    Polynomial Subtract(const Polynomial& other) const;
+    bool Multiply(const Polynomial& other, Polynomial& result, size_t* work = nullptr) const;
+    bool Power(uint32_t exponent, Polynomial& result, size_t* work = nullptr) const;
+
+private:
+    struct MonomialHash {
+        size_t operator()(const Monomial& monomial) const;
+    };
+
+    bool IsUnivariate(uint32_t& symbol) const;
+    Polynomial MultiplyDense(const Polynomial& other, uint32_t symbol) const;
+    Polynomial MultiplySparse(const Polynomial& other) const;
+    void AddTerm(const Monomial& monomial, uint32_t coefficient);
+
+    std::unordered_map<Monomial, uint32_t, MonomialHash> _terms;
+};
+
+#endif //POLYNOMIAL_H
@@ -0,0 +1,366 @@
+//
+// Implements the SimplifierServer Class
+// Author: Max Benson
+// Date: 11/15/2021
+//
+
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+using std::cerr;
+using std::endl;
+using std::stringstream;
+
+#include "ExpressionTree.h"
+#include "SimplifierServer.h"
+
+// Defaults for the limits placed on clients
+static const size_t DefaultMaxRequestSize = 1 << 20;
+static const size_t DefaultMaxDepth = 10000;
+static const size_t DefaultCacheSize = 4096;
+static const size_t DefaultIdleTimeout = 30;
+
+/**
+ * Constructor
+ * @param socketPath file system path of the Unix domain socket to listen on
+ * @param workers number of worker threads serving connections
+ */
+SimplifierServer::SimplifierServer(const string& socketPath, size_t workers) {
+    _socketPath = socketPath;
+    _workers = workers > 0 ? workers : 1;
+    _maxRequestSize = DefaultMaxRequestSize;
+    _maxDepth = DefaultMaxDepth;
+    _cacheSize = DefaultCacheSize;
+    _idleTimeout = DefaultIdleTimeout;
+    _listenFd = -1;
+}
+
+/**
+ * Destructor
+ * Closes the listening socket and removes it from the file system
+ */
+SimplifierServer::~SimplifierServer() {
+    if (_listenFd >= 0) {
+        close(_listenFd);
+        unlink(_socketPath.c_str());
+    }
+}
+
+/**
+ * Bind the socket, start the workers, and accept connections forever
+ * @return false if the socket could not be set up, otherwise does not return
+ */
+bool SimplifierServer::Run() {
+    struct sockaddr_un address;
+
+    if (_socketPath.length() >= sizeof(address.sun_path)) {
+        cerr << "Error: socket path too long" << endl;
+        return false;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    _listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (_listenFd < 0) {
+        cerr << "Error: socket: " << strerror(errno) << endl;
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, _socketPath.c_str(), sizeof(address.sun_path) - 1);
+    if (!RemoveStaleSocket(address)) {
+        // Leave whatever is at the path to its owner
+        close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+    if (bind(_listenFd, (struct sockaddr*) &address, sizeof(address)) < 0 || listen(_listenFd, 64) < 0) {
+        cerr << "Error: bind: " << strerror(errno) << endl;
+        close(_listenFd);
+        _listenFd = -1;
+        return false;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < _workers; i ++) {
+        threads.emplace_back(&SimplifierServer::WorkerLoop, this);
+    }
+
+    while (true) {
+        int fd = accept(_listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            cerr << "Error: accept: " << strerror(errno) << endl;
+            break;
+        }
+        std::lock_guard<std::mutex> lock(_mutex);
+        _connections.push(fd);
+        _ready.notify_one();
+    }
+
+    // Accept failed for good, release the workers and wait for them
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _workers; i ++) {
+            _connections.push(-1);
+        }
+        _ready.notify_all();
+    }
+    for (size_t i = 0; i < threads.size(); i ++) {
+        threads[i].join();
+    }
+    return false;
+}
+
+/**
+ * Remove the socket left at the path by a server that is no longer running.
+ * Anything else at the path, including the socket of a server that is still
+ * accepting connections, is left alone
+ * @param address address of the socket path
+ * @return true if nothing is at the path now, false after reporting why not
+ */
+bool SimplifierServer::RemoveStaleSocket(const struct sockaddr_un& address) {
+    struct stat status;
+
+    if (lstat(address.sun_path, &status) < 0) {
+        if (errno == ENOENT) {
+            return true;
+        }
+        cerr << "Error: " << address.sun_path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    if (!S_ISSOCK(status.st_mode)) {
+        cerr << "Error: " << address.sun_path << " exists and is not a socket" << endl;
+        return false;
+    }
+
+    // Only a socket that refuses connections is left over from an old server
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        cerr << "Error: socket: " << strerror(errno) << endl;
+        return false;
+    }
+    int result = connect(fd, (const struct sockaddr*) &address, sizeof(address));
+    int error = errno;
+    close(fd);
+    if (result == 0) {
+        cerr << "Error: a server is already listening on " << address.sun_path << endl;
+        return false;
+    }
+    if (error != ECONNREFUSED) {
+        cerr << "Error: " << address.sun_path << ": " << strerror(error) << endl;
+        return false;
+    }
+    if (unlink(address.sun_path) < 0 && errno != ENOENT) {
+        cerr << "Error: " << address.sun_path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Body of each worker thread: serve one connection at a time until told to stop
+ * by receiving a negative descriptor
+ */
+void SimplifierServer::WorkerLoop() {
+    Worker worker;
+
+    SymbolTable::SetCurrent(&worker.symbols);
+    StructureTable::SetCurrent(&worker.structures);
+    while (true) {
+        int fd;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _ready.wait(lock, [this] { return !_connections.empty(); });
+            fd = _connections.front();
+            _connections.pop();
+        }
+        if (fd < 0) {
+            return;
+        }
+        ServeConnection(worker, fd);
+        close(fd);
+    }
+}
+
+/**
+ * Read request frames from the connection and answer each in turn.  A frame
+ * larger than the limit is skipped without being stored and answered with
+ * an error, so the client can read the reply and go on sending.  A client
+ * that sends nothing, or reads nothing, for the idle timeout is dropped so
+ * that it cannot hold on to the worker
+ * @param worker state of the worker serving the connection
+ * @param fd connected socket
+ */
+void SimplifierServer::ServeConnection(Worker& worker, int fd) {
+    unsigned char header[4];
+    struct timeval timeout;
+
+    timeout.tv_sec = _idleTimeout;
+    timeout.tv_usec = 0;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)) < 0) {
+        return;
+    }
+    while (ReadFully(fd, (char*) header, sizeof(header))) {
+        size_t length = ((size_t) header[0] << 24) | ((size_t) header[1] << 16) | ((size_t) header[2] << 8) | header[3];
+
+        if (length > _maxRequestSize) {
+            if (!SkipFully(fd, length) || !WriteFrame(fd, "ERR request too large\n")) {
+                return;
+            }
+            continue;
+        }
+        worker.request.resize(length);
+        if (length > 0 && !ReadFully(fd, &worker.request[0], length)) {
+            return;
+        }
+        ProcessBatch(worker);
+        if (!WriteFrame(fd, worker.response)) {
+            return;
+        }
+    }
+}
+
+/**
+ * Answer every expression of the request held by the worker, then forget
+ * the names and subtrees interned for it, so that the worker's memory does
+ * not grow with everything it has ever served
+ * @param worker holds the request, receives the response
+ */
+void SimplifierServer::ProcessBatch(Worker& worker) {
+    size_t start = 0;
+
+    worker.response.clear();
+    while (start < worker.request.length()) {
+        size_t end = worker.request.find('\n', start);
+        if (end == string::npos) {
+            end = worker.request.length();
+        }
+        ProcessExpression(worker, worker.request.substr(start, end - start));
+        start = end + 1;
+    }
+    worker.symbols.Clear();
+    worker.structures.Clear();
+}
+
+/**
+ * Append the result for a single postfix expression to the worker's response.
+ * Results are cached per worker so that repeated expressions are answered
+ * without rebuilding the tree.
+ * @param worker state of the worker
+ * @param postfix expression to simplify
+ */
+void SimplifierServer::ProcessExpression(Worker& worker, const string& postfix) {
+    std::unordered_map<string, string>::const_iterator cached = worker.cache.find(postfix);
+
+    if (cached != worker.cache.end()) {
+        worker.response += cached->second;
+        return;
+    }
+
+    ExpressionTree expTree;
+    string result;
+
+    // The error goes back to the client in the reply, not to the server's output
+    expTree.SetReportErrors(false);
+    expTree.SetMaxDepth(_maxDepth);
+    if (expTree.BuildExpressionTree(postfix)) {
+        stringstream ss;
+
+        ss << "OK " << expTree << '\t';
+        expTree.Simplify();
+        ss << expTree << '\n';
+        result = ss.str();
+    } else {
+        result = "ERR invalid postfix or depth limit exceeded\n";
+    }
+    worker.response += result;
+
+    if (worker.cache.size() >= _cacheSize) {
+        worker.cache.clear();
+    }
+    worker.cache.emplace(postfix, result);
+}
+
+/**
+ * Read exactly length bytes, retrying on short reads
+ * @return true if all bytes were read, false on error or end of file
+ */
+bool SimplifierServer::ReadFully(int fd, char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t count = read(fd, buffer, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        length -= count;
+    }
+    return true;
+}
+
+/**
+ * Read and discard exactly length bytes
+ * @return true if all bytes were read, false on error or end of file
+ */
+bool SimplifierServer::SkipFully(int fd, size_t length) {
+    char buffer[4096];
+
+    while (length > 0) {
+        size_t count = length < sizeof(buffer) ? length : sizeof(buffer);
+        if (!ReadFully(fd, buffer, count)) {
+            return false;
+        }
+        length -= count;
+    }
+    return true;
+}
+
+/**
+ * Write exactly length bytes, retrying on short writes
+ * @return true if all bytes were written, false on error
+ */
+bool SimplifierServer::WriteFully(int fd, const char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t count = send(fd, buffer, length, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        length -= count;
+    }
+    return true;
+}
+
+/**
+ * Write a payload preceded by its 4 byte big-endian length
+ * @return true if the frame was written, false on error
+ */
+bool SimplifierServer::WriteFrame(int fd, const string& payload) {
+    uint32_t length = payload.length();
+    unsigned char header[4];
+
+    header[0] = (length >> 24) & 0xFF;
+    header[1] = (length >> 16) & 0xFF;
+    header[2] = (length >> 8) & 0xFF;
+    header[3] = length & 0xFF;
+    return WriteFully(fd, (const char*) header, sizeof(header)) && WriteFully(fd, payload.data(), payload.length());
+}
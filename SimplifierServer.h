@@ -0,0 +1,81 @@
+//
+// Interface Definition for the SimplifierServer Class
+// Author: Max Benson
+// Date: 11/15/2021
+//
+// Long running daemon mode: accepts length-prefixed batches of postfix
+// expressions over a Unix domain socket and answers each batch with a
+// length-prefixed block of results.
+//
+// Wire format (all lengths are 4 byte big-endian unsigned integers):
+//   request  := length batch        batch is postfix expressions separated by '\n'
+//   response := length results      one result line per expression in the batch
+//   result   := "OK " infix '\t' simplified '\n'
+//             | "ERR " reason '\n'
+// Clients may pipeline any number of requests on a connection, responses are
+// returned in the order the requests were sent.
+// A batch longer than the request size limit is skipped and answered with
+// the single result "ERR request too large".
+// Connections idle for longer than the idle timeout are closed.
+//
+#ifndef SIMPLIFIERSERVER_H
+#define SIMPLIFIERSERVER_H
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+using std::string;
+
+#include "InternTable.h"
+
+class SimplifierServer {
+public:
+    SimplifierServer(const string& socketPath, size_t workers);
+    ~SimplifierServer();
+
+    void SetMaxRequestSize(size_t bytes) { _maxRequestSize = bytes; };
+    void SetMaxDepth(size_t depth) { _maxDepth = depth; };
+    void SetCacheSize(size_t entries) { _cacheSize = entries; };
+    void SetIdleTimeout(size_t seconds) { _idleTimeout = seconds; };
+
+    bool Run();
+
+private:
+    // State kept warm by each worker thread across connections.  The intern
+    // tables are the worker's own and are cleared after every batch, while
+    // the cache holds only text and so survives them
+    struct Worker {
+        std::unordered_map<string, string> cache;
+        string request;
+        string response;
+        SymbolTable symbols;
+        StructureTable structures;
+    };
+
+    bool RemoveStaleSocket(const struct sockaddr_un& address);
+    void WorkerLoop();
+    void ServeConnection(Worker& worker, int fd);
+    void ProcessBatch(Worker& worker);
+    void ProcessExpression(Worker& worker, const string& postfix);
+
+    static bool ReadFully(int fd, char* buffer, size_t length);
+    static bool SkipFully(int fd, size_t length);
+    static bool WriteFully(int fd, const char* buffer, size_t length);
+    static bool WriteFrame(int fd, const string& payload);
+
+    string _socketPath;
+    size_t _workers;
+    size_t _maxRequestSize;
+    size_t _maxDepth;
+    size_t _cacheSize;
+    size_t _idleTimeout;
+    int _listenFd;
+
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::queue<int> _connections;
+};
+
+#endif //SIMPLIFIERSERVER_H
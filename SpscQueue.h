@@ -0,0 +1,116 @@
+//
+// Bounded Lock Free Single Producer Single Consumer Queue
+// Author: Max Benson
+// Date: 02/07/2022
+//
+// A fixed size ring buffer connecting exactly one producing thread to
+// exactly one consuming thread.  Items are moved in and out, so a queue of
+// std::unique_ptr hands ownership of a buffer from one thread to the next
+// without copying it.  Push and pop never block or lock; they fail when
+// the queue is full or empty and the caller decides how to wait.
+//
+// The producer only writes _tail and the consumer only writes _head, each
+// publishing with a release store that the other side reads with an acquire
+// load.  Each side also keeps a private copy of the other's index, so it
+// only touches the shared cache line when its copy says the queue is full
+// or empty.
+//
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <assert.h>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue(size_t capacity);
+
+    SpscQueue(const SpscQueue&) = delete;
+    const SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool TryPush(T&& item);
+    bool TryPop(T& item);
+    size_t Size() const;
+    size_t Capacity() const { return _mask + 1; };
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    std::vector<T> _slots;
+    size_t _mask;
+
+    // Written by the consumer
+    alignas(CacheLineSize) std::atomic<size_t> _head;
+    size_t _cachedTail;
+
+    // Written by the producer
+    alignas(CacheLineSize) std::atomic<size_t> _tail;
+    size_t _cachedHead;
+};
+
+/**
+ * Constructor
+ * @param capacity number of items the queue holds, must be a power of two
+ */
+template <typename T>
+SpscQueue<T>::SpscQueue(size_t capacity) : _slots(capacity), _mask(capacity - 1), _head(0), _cachedTail(0), _tail(0), _cachedHead(0) {
+    assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+}
+
+/**
+ * Add an item at the tail.  Only the producer thread may call this.
+ * @param item item to move into the queue, left unchanged if the queue is full
+ * @return true if added, false if the queue is full
+ */
+template <typename T>
+bool SpscQueue<T>::TryPush(T&& item) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+
+    if (tail - _cachedHead > _mask) {
+        _cachedHead = _head.load(std::memory_order_acquire);
+        if (tail - _cachedHead > _mask) {
+            return false;
+        }
+    }
+    _slots[tail & _mask] = std::move(item);
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Remove the item at the head.  Only the consumer thread may call this.
+ * @param item receives the item
+ * @return true if an item was removed, false if the queue is empty
+ */
+template <typename T>
+bool SpscQueue<T>::TryPop(T& item) {
+    size_t head = _head.load(std::memory_order_relaxed);
+
+    if (head == _cachedTail) {
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        if (head == _cachedTail) {
+            return false;
+        }
+    }
+    item = std::move(_slots[head & _mask]);
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * Number of items in the queue.  Exact only when neither thread is using it,
+ * otherwise a snapshot good enough for statistics.
+ * @return number of items
+ */
+template <typename T>
+size_t SpscQueue<T>::Size() const {
+    size_t head = _head.load(std::memory_order_acquire);
+    size_t tail = _tail.load(std::memory_order_acquire);
+
+    return tail >= head ? tail - head : 0;
+}
+
+#endif //SPSCQUEUE_H
@@ -0,0 +1,586 @@
+//
+// Compile time expression trees
+// Author: Max Benson
+// Date: 12/06/2021
+//
+// Header only counterpart of ExpressionTree for formulas that are fixed at
+// build time.  Two forms are offered:
+//
+//  - Expression templates.  An expression is a type built from StaticNum,
+//    StaticVar, StaticAdd, StaticSub, StaticMul, StaticDiv and StaticPow,
+//    usually written with the ordinary operators (there is no operator for
+//    StaticPow, since C++ gives ^ a lower precedence than + and -):
+//        StaticVar<0> x;  StaticVar<1> y;
+//        using E = StaticSimplified<decltype((x + StaticNum<0>()) * (y - y))>;
+//    StaticSimplified applies the SimplifyTree rules by template
+//    specialization, and E::Evaluate(values) compiles to straight line code.
+//
+//  - Constexpr postfix.  StaticPostfix<N> parses a postfix string literal in
+//    a constant expression, simplifying each operator as it is pushed, into
+//    an array of N nodes.  Variables are numbered in order of first
+//    appearance.  Every token takes a node, and combining powers appends up
+//    to three more, so N must leave room for those; a rule that would need
+//    more nodes than are left is skipped, and more than N tokens make the
+//    expression invalid.
+//        constexpr StaticPostfix<16> p("x 2 3 + *");
+//        static_assert(p.Evaluate(values) == ..., "");
+//
+// Either form converts to postfix text for BuildExpressionTree when the
+// dynamic ExpressionTree is needed.  tests/StaticExpressionTest.cpp checks
+// both against the rules of SimplifyTree at build time.
+//
+#ifndef STATICEXPRESSION_H
+#define STATICEXPRESSION_H
+
+#include <string>
+#include <type_traits>
+using std::string;
+using std::to_string;
+
+#include "WrappedArithmetic.h"
+
+// Largest exponent built by combining powers, the same as Polynomial::MaxDegree
+static const int StaticMaxDegree = 1 << 16;
+
+//
+// Expression template node types
+//
+
+struct StaticExpressionBase {};
+
+template <int Value>
+struct StaticNum : StaticExpressionBase {
+    static constexpr int Evaluate(const int*) { return Value; }
+    static string Infix(const char* const*, bool) { return to_string(Value); }
+    static string Postfix(const char* const*) { return Value < 0 ? "0 " + to_string(-Value) + " -" : to_string(Value); }
+};
+
+template <int Id>
+struct StaticVar : StaticExpressionBase {
+    static constexpr int Evaluate(const int* values) { return values[Id]; }
+    static string Infix(const char* const* names, bool) { return names[Id]; }
+    static string Postfix(const char* const* names) { return names[Id]; }
+};
+
+// Negated variable, what SimplifyTree produces for 0 - x
+template <typename Exp>
+struct StaticNeg : StaticExpressionBase {
+    static constexpr int Evaluate(const int* values) { return -Exp::Evaluate(values); }
+    static string Infix(const char* const* names, bool) { return "-" + Exp::Infix(names, true); }
+    static string Postfix(const char* const* names) { return "0 " + Exp::Postfix(names) + " -"; }
+};
+
+template <char Op, typename Left, typename Right>
+struct StaticBinary : StaticExpressionBase {
+    static string Infix(const char* const* names, bool fNeedOuterParen) {
+        string s = Left::Infix(names, true) + Op + Right::Infix(names, true);
+        return fNeedOuterParen ? "(" + s + ")" : s;
+    }
+    static string Postfix(const char* const* names) {
+        return Left::Postfix(names) + " " + Right::Postfix(names) + " " + Op;
+    }
+};
+
+template <typename Left, typename Right>
+struct StaticAdd : StaticBinary<'+', Left, Right> {
+    static constexpr int Evaluate(const int* values) { return Left::Evaluate(values) + Right::Evaluate(values); }
+};
+
+template <typename Left, typename Right>
+struct StaticSub : StaticBinary<'-', Left, Right> {
+    static constexpr int Evaluate(const int* values) { return Left::Evaluate(values) - Right::Evaluate(values); }
+};
+
+template <typename Left, typename Right>
+struct StaticMul : StaticBinary<'*', Left, Right> {
+    static constexpr int Evaluate(const int* values) { return Left::Evaluate(values) * Right::Evaluate(values); }
+};
+
+template <typename Left, typename Right>
+struct StaticDiv : StaticBinary<'/', Left, Right> {
+    static constexpr int Evaluate(const int* values) {
+        return (int) WrappedDivide((uint32_t) Left::Evaluate(values), (uint32_t) Right::Evaluate(values));
+    }
+};
+
+template <typename Left, typename Right>
+struct StaticPow : StaticBinary<'^', Left, Right> {
+    static constexpr int Evaluate(const int* values) {
+        return (int) WrappedPower((uint32_t) Left::Evaluate(values), (uint32_t) Right::Evaluate(values));
+    }
+};
+
+template <typename Exp>
+using IsStaticExpression = std::is_base_of<StaticExpressionBase, Exp>;
+
+template <typename Left, typename Right>
+constexpr typename std::enable_if<IsStaticExpression<Left>::value && IsStaticExpression<Right>::value, StaticAdd<Left, Right> >::type
+operator+(Left, Right) { return StaticAdd<Left, Right>(); }
+
+template <typename Left, typename Right>
+constexpr typename std::enable_if<IsStaticExpression<Left>::value && IsStaticExpression<Right>::value, StaticSub<Left, Right> >::type
+operator-(Left, Right) { return StaticSub<Left, Right>(); }
+
+template <typename Left, typename Right>
+constexpr typename std::enable_if<IsStaticExpression<Left>::value && IsStaticExpression<Right>::value, StaticMul<Left, Right> >::type
+operator*(Left, Right) { return StaticMul<Left, Right>(); }
+
+template <typename Left, typename Right>
+constexpr typename std::enable_if<IsStaticExpression<Left>::value && IsStaticExpression<Right>::value, StaticDiv<Left, Right> >::type
+operator/(Left, Right) { return StaticDiv<Left, Right>(); }
+
+//
+// Same expression test.  Like IsSameTree the operands of + and * may appear
+// in either order; unlike it, chains are not regrouped.
+//
+
+template <typename Exp1, typename Exp2>
+struct StaticIsSame : std::is_same<Exp1, Exp2> {};
+
+template <typename A, typename B, typename C, typename D>
+struct StaticIsSame<StaticAdd<A, B>, StaticAdd<C, D> >
+    : std::integral_constant<bool, (StaticIsSame<A, C>::value && StaticIsSame<B, D>::value) ||
+                                   (StaticIsSame<A, D>::value && StaticIsSame<B, C>::value)> {};
+
+template <typename A, typename B, typename C, typename D>
+struct StaticIsSame<StaticMul<A, B>, StaticMul<C, D> >
+    : std::integral_constant<bool, (StaticIsSame<A, C>::value && StaticIsSame<B, D>::value) ||
+                                   (StaticIsSame<A, D>::value && StaticIsSame<B, C>::value)> {};
+
+template <typename A, typename B, typename C, typename D>
+struct StaticIsSame<StaticSub<A, B>, StaticSub<C, D> >
+    : std::integral_constant<bool, StaticIsSame<A, C>::value && StaticIsSame<B, D>::value> {};
+
+//
+// Simplification rules, applied to operands that are already simplified.
+// These are the rules SimplifyTree implements:
+//  - arithmetic on two numbers is folded
+//  - 0 * exp and exp * 0 become 0
+//  - x + 0, 0 + x, x - 0 become x, and 0 - x becomes -x, for a variable x
+//  - exp - exp becomes 0
+//  - division and powers of two numbers are folded, except x / 0 and 0 ^ n with n < 0
+//  - exp ^ 0 and 1 ^ exp become 1, exp ^ 1 and exp / 1 become exp
+//  - 0 / exp becomes 0
+//  - exp * exp becomes exp ^ 2
+// The expression templates differ from SimplifyTree in that
+//  - exp - exp only matches when the two sides are the same up to swapping
+//    the operands of + and *; SimplifyTree also regroups chains and folds
+//    their numbers, so (x+2)+3 - (x+5) becomes 0 there but not here
+//  - exp * exp only matches identical types, and b ^ m * b ^ n, chains
+//    of factors, and (b ^ m) ^ n are not combined into one power
+// StaticPostfix below has all of these rules except the regrouping.
+//
+
+template <typename Left, typename Right>
+struct StaticSimplifyAdd { using type = StaticAdd<Left, Right>; };
+template <int A, int B>
+struct StaticSimplifyAdd<StaticNum<A>, StaticNum<B> > { using type = StaticNum<A + B>; };
+template <int Id>
+struct StaticSimplifyAdd<StaticVar<Id>, StaticNum<0> > { using type = StaticVar<Id>; };
+template <int Id>
+struct StaticSimplifyAdd<StaticNum<0>, StaticVar<Id> > { using type = StaticVar<Id>; };
+
+template <typename Left, typename Right, bool fSame = StaticIsSame<Left, Right>::value>
+struct StaticSimplifySub { using type = StaticSub<Left, Right>; };
+template <typename Left, typename Right>
+struct StaticSimplifySub<Left, Right, true> { using type = StaticNum<0>; };
+template <int A, int B>
+struct StaticSimplifySub<StaticNum<A>, StaticNum<B>, false> { using type = StaticNum<A - B>; };
+template <int Id>
+struct StaticSimplifySub<StaticVar<Id>, StaticNum<0>, false> { using type = StaticVar<Id>; };
+template <int Id>
+struct StaticSimplifySub<StaticNum<0>, StaticVar<Id>, false> { using type = StaticNeg<StaticVar<Id> >; };
+
+template <typename Left, typename Right, bool fSame = std::is_same<Left, Right>::value>
+struct StaticSimplifyMul { using type = StaticMul<Left, Right>; };
+template <typename Exp>
+struct StaticSimplifyMul<Exp, Exp, true> { using type = StaticPow<Exp, StaticNum<2> >; };
+template <int A>
+struct StaticSimplifyMul<StaticNum<A>, StaticNum<A>, true> { using type = StaticNum<A * A>; };
+template <int A, int B>
+struct StaticSimplifyMul<StaticNum<A>, StaticNum<B>, false> { using type = StaticNum<A * B>; };
+template <typename Right>
+struct StaticSimplifyMul<StaticNum<0>, Right, false> { using type = StaticNum<0>; };
+template <typename Left>
+struct StaticSimplifyMul<Left, StaticNum<0>, false> { using type = StaticNum<0>; };
+template <int B>
+struct StaticSimplifyMul<StaticNum<0>, StaticNum<B>, false> { using type = StaticNum<0>; };
+template <int A>
+struct StaticSimplifyMul<StaticNum<A>, StaticNum<0>, false> { using type = StaticNum<0>; };
+
+template <typename Left, typename Right>
+struct StaticSimplifyDiv { using type = StaticDiv<Left, Right>; };
+template <int A, int B>
+struct StaticSimplifyDiv<StaticNum<A>, StaticNum<B> > {
+    using type = typename std::conditional<B == 0, StaticDiv<StaticNum<A>, StaticNum<B> >,
+                                           StaticNum<(int) WrappedDivide((uint32_t) A, (uint32_t) B)> >::type;
+};
+template <typename Left>
+struct StaticSimplifyDiv<Left, StaticNum<1> > { using type = Left; };
+template <int A>
+struct StaticSimplifyDiv<StaticNum<A>, StaticNum<1> > { using type = StaticNum<A>; };
+template <typename Right>
+struct StaticSimplifyDiv<StaticNum<0>, Right> { using type = StaticNum<0>; };
+template <int B>
+struct StaticSimplifyDiv<StaticNum<0>, StaticNum<B> > { using type = StaticNum<0>; };
+template <>
+struct StaticSimplifyDiv<StaticNum<0>, StaticNum<1> > { using type = StaticNum<0>; };
+
+template <typename Left, typename Right>
+struct StaticSimplifyPow { using type = StaticPow<Left, Right>; };
+template <int A, int B>
+struct StaticSimplifyPow<StaticNum<A>, StaticNum<B> > {
+    using type = typename std::conditional<A == 0 && B < 0, StaticPow<StaticNum<A>, StaticNum<B> >,
+                                           StaticNum<(int) WrappedPower((uint32_t) A, (uint32_t) B)> >::type;
+};
+template <typename Left>
+struct StaticSimplifyPow<Left, StaticNum<0> > { using type = StaticNum<1>; };
+template <int A>
+struct StaticSimplifyPow<StaticNum<A>, StaticNum<0> > { using type = StaticNum<1>; };
+template <typename Left>
+struct StaticSimplifyPow<Left, StaticNum<1> > { using type = Left; };
+template <int A>
+struct StaticSimplifyPow<StaticNum<A>, StaticNum<1> > { using type = StaticNum<A>; };
+template <typename Right>
+struct StaticSimplifyPow<StaticNum<1>, Right> { using type = StaticNum<1>; };
+template <int B>
+struct StaticSimplifyPow<StaticNum<1>, StaticNum<B> > { using type = StaticNum<1>; };
+template <>
+struct StaticSimplifyPow<StaticNum<1>, StaticNum<0> > { using type = StaticNum<1>; };
+template <>
+struct StaticSimplifyPow<StaticNum<1>, StaticNum<1> > { using type = StaticNum<1>; };
+
+template <typename Exp>
+struct StaticSimplify { using type = Exp; };
+template <typename Left, typename Right>
+struct StaticSimplify<StaticAdd<Left, Right> > {
+    using type = typename StaticSimplifyAdd<typename StaticSimplify<Left>::type, typename StaticSimplify<Right>::type>::type;
+};
+template <typename Left, typename Right>
+struct StaticSimplify<StaticSub<Left, Right> > {
+    using type = typename StaticSimplifySub<typename StaticSimplify<Left>::type, typename StaticSimplify<Right>::type>::type;
+};
+template <typename Left, typename Right>
+struct StaticSimplify<StaticMul<Left, Right> > {
+    using type = typename StaticSimplifyMul<typename StaticSimplify<Left>::type, typename StaticSimplify<Right>::type>::type;
+};
+
+template <typename Left, typename Right>
+struct StaticSimplify<StaticDiv<Left, Right> > {
+    using type = typename StaticSimplifyDiv<typename StaticSimplify<Left>::type, typename StaticSimplify<Right>::type>::type;
+};
+template <typename Left, typename Right>
+struct StaticSimplify<StaticPow<Left, Right> > {
+    using type = typename StaticSimplifyPow<typename StaticSimplify<Left>::type, typename StaticSimplify<Right>::type>::type;
+};
+
+template <typename Exp>
+using StaticSimplified = typename StaticSimplify<Exp>::type;
+
+//
+// Constexpr postfix expressions
+//
+
+template <size_t MaxTokens>
+class StaticPostfix {
+public:
+    constexpr StaticPostfix(const char* postfix) : _text(postfix), _nodes(), _count(0), _root(-1), _variables(0), _valid(false) {
+        int stack[MaxTokens] = {};
+        size_t depth = 0;
+        size_t i = 0;
+
+        while (true) {
+            while (postfix[i] == ' ' || postfix[i] == '\t') {
+                i++;
+            }
+            if (postfix[i] == '\0') {
+                break;
+            }
+            size_t start = i;
+            while (postfix[i] != '\0' && postfix[i] != ' ' && postfix[i] != '\t') {
+                i++;
+            }
+            if (_count == MaxTokens) {
+                return;
+            }
+            if (IsDigit(postfix[start])) {
+                int value = 0;
+                for (size_t j = start; j < i; j ++) {
+                    if (!IsDigit(postfix[j])) {
+                        return;
+                    }
+                    value = 10*value + (postfix[j] - '0');
+                }
+                stack[depth++] = AddNode('n', value, -1, -1);
+            } else if (IsAlpha(postfix[start])) {
+                for (size_t j = start; j < i; j ++) {
+                    if (!IsAlpha(postfix[j]) && !IsDigit(postfix[j])) {
+                        return;
+                    }
+                }
+                stack[depth++] = AddNode('v', FindVariable(start, i), static_cast<int>(start), static_cast<int>(i));
+            } else if (i == start + 1 && (postfix[start] == '+' || postfix[start] == '-' || postfix[start] == '*' ||
+                                           postfix[start] == '/' || postfix[start] == '^')) {
+                if (depth < 2) {
+                    return;
+                }
+                int right = stack[--depth];
+                int left = stack[--depth];
+                stack[depth++] = SimplifyNode(postfix[start], left, right);
+            } else {
+                return;
+            }
+        }
+        if (depth == 1) {
+            _root = stack[0];
+            _valid = true;
+        }
+    }
+
+    constexpr bool IsValid() const { return _valid; }
+    constexpr size_t VariableCount() const { return _variables; }
+    constexpr int Evaluate(const int* values) const { return EvaluateNode(_root, values); }
+    constexpr bool IsNumber() const { return _valid && _nodes[_root].op == 'n'; }
+    constexpr size_t Size() const { return _valid ? SizeNode(_root) : 0; }
+
+    string VariableName(size_t id) const {
+        for (size_t i = 0; i < _count; i ++) {
+            if (_nodes[i].op == 'v' && _nodes[i].value == static_cast<int>(id)) {
+                return string(_text + _nodes[i].left, _nodes[i].right - _nodes[i].left);
+            }
+        }
+        return string();
+    }
+    string Postfix() const { return _valid ? PostfixNode(_root) : string(); }
+
+private:
+    // op is 'n' number, 'v' variable, '~' negated variable, or an operator
+    // For variables value is the id and left/right delimit the name in the text
+    struct Node {
+        char op = 0;
+        int value = 0;
+        int left = -1;
+        int right = -1;
+    };
+
+    static constexpr bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+    static constexpr bool IsAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+
+    constexpr int AddNode(char op, int value, int left, int right) {
+        _nodes[_count].op = op;
+        _nodes[_count].value = value;
+        _nodes[_count].left = left;
+        _nodes[_count].right = right;
+        return static_cast<int>(_count++);
+    }
+
+    constexpr int FindVariable(size_t start, size_t end) {
+        for (size_t i = 0; i < _count; i ++) {
+            if (_nodes[i].op == 'v' && static_cast<size_t>(_nodes[i].right - _nodes[i].left) == end - start) {
+                bool fSame = true;
+                for (size_t j = 0; j < end - start; j ++) {
+                    fSame = fSame && _text[_nodes[i].left + j] == _text[start + j];
+                }
+                if (fSame) {
+                    return _nodes[i].value;
+                }
+            }
+        }
+        return static_cast<int>(_variables++);
+    }
+
+    constexpr bool IsSameNode(int node1, int node2) const {
+        const Node& a = _nodes[node1];
+        const Node& b = _nodes[node2];
+
+        if (a.op != b.op) {
+            return false;
+        }
+        if (a.op == 'n' || a.op == 'v') {
+            return a.value == b.value;
+        }
+        if (a.op == '~') {
+            return IsSameNode(a.left, b.left);
+        }
+        if (IsSameNode(a.left, b.left) && IsSameNode(a.right, b.right)) {
+            return true;
+        }
+        return (a.op == '+' || a.op == '*') && IsSameNode(a.left, b.right) && IsSameNode(a.right, b.left);
+    }
+
+    constexpr bool IsConstantNode(int node) const {
+        const Node& n = _nodes[node];
+
+        if (n.op == 'n') {
+            return true;
+        }
+        if (n.op == 'v' || n.op == '~') {
+            return false;
+        }
+        return IsConstantNode(n.left) && IsConstantNode(n.right);
+    }
+
+    // A positive power b ^ n gives base b and exponent n, anything else is its own base
+    constexpr int PowerBase(int node, int& exponent) const {
+        const Node& n = _nodes[node];
+
+        if (n.op == '^' && _nodes[n.right].op == 'n' && _nodes[n.right].value > 0) {
+            exponent = _nodes[n.right].value;
+            return n.left;
+        }
+        exponent = 1;
+        return node;
+    }
+
+    constexpr int MakePower(int base, int exponent) {
+        if (exponent == 1) {
+            return base;
+        }
+        return AddNode('^', 0, base, AddNode('n', exponent, -1, -1));
+    }
+
+    // b ^ m * b ^ n becomes b ^ (m+n), also with a matching factor inside
+    // a product on the left, as CombinePowers does; -1 if nothing combines
+    constexpr int CombinePowers(int left, int right) {
+        int leftExponent = 0;
+        int rightExponent = 0;
+        int rightBase = PowerBase(right, rightExponent);
+        int leftBase = PowerBase(left, leftExponent);
+        int rest = -1;
+
+        if (IsConstantNode(rightBase) || _count + 3 > MaxTokens) {
+            return -1;
+        }
+        if (!IsSameNode(leftBase, rightBase)) {
+            const Node& l = _nodes[left];
+            if (l.op != '*') {
+                return -1;
+            }
+            leftBase = PowerBase(l.right, leftExponent);
+            rest = l.left;
+            if (!IsSameNode(leftBase, rightBase)) {
+                leftBase = PowerBase(l.left, leftExponent);
+                rest = l.right;
+                if (!IsSameNode(leftBase, rightBase)) {
+                    return -1;
+                }
+            }
+        }
+        if (leftExponent + rightExponent > StaticMaxDegree) {
+            return -1;
+        }
+
+        int power = MakePower(leftBase, leftExponent + rightExponent);
+        return rest < 0 ? power : AddNode('*', 0, rest, power);
+    }
+
+    // Same rules, in the same order, as SimplifyNode, except that operands
+    // are compared by IsSameNode, without regrouping chains
+    constexpr int SimplifyNode(char op, int left, int right) {
+        const Node& l = _nodes[left];
+        const Node& r = _nodes[right];
+
+        if (l.op == 'n' && r.op == 'n' && !(op == '/' && r.value == 0) && !(op == '^' && l.value == 0 && r.value < 0)) {
+            return AddNode('n', Fold(op, l.value, r.value), -1, -1);
+        }
+        if (op == '^' && ((r.op == 'n' && r.value == 0) || (l.op == 'n' && l.value == 1))) {
+            return AddNode('n', 1, -1, -1);
+        }
+        if ((op == '/' || op == '^') && r.op == 'n' && r.value == 1) {
+            return left;
+        }
+        if (op == '^' && r.op == 'n' && r.value > 0 && l.op == '^' && _nodes[l.right].op == 'n' && _nodes[l.right].value > 0 &&
+            (long long) _nodes[l.right].value * r.value <= StaticMaxDegree && _count + 2 <= MaxTokens) {
+            return MakePower(l.left, _nodes[l.right].value * r.value);
+        }
+        if (op == '/' && l.op == 'n' && l.value == 0) {
+            return AddNode('n', 0, -1, -1);
+        }
+        if (op == '*') {
+            int power = CombinePowers(left, right);
+            if (power >= 0) {
+                return power;
+            }
+        }
+        if (op == '*' && ((l.op == 'n' && l.value == 0) || (r.op == 'n' && r.value == 0))) {
+            return AddNode('n', 0, -1, -1);
+        }
+        if (op == '-' && IsSameNode(left, right)) {
+            return AddNode('n', 0, -1, -1);
+        }
+        if ((op == '+' || op == '-') && l.op == 'v' && r.op == 'n' && r.value == 0) {
+            return left;
+        }
+        if (op == '+' && l.op == 'n' && l.value == 0 && r.op == 'v') {
+            return right;
+        }
+        if (op == '-' && l.op == 'n' && l.value == 0 && r.op == 'v') {
+            return AddNode('~', 0, right, -1);
+        }
+        return AddNode(op, 0, left, right);
+    }
+
+    static constexpr int Fold(char op, int left, int right) {
+        switch (op) {
+            case '+':
+                return left + right;
+            case '-':
+                return left - right;
+            case '/':
+                return (int) WrappedDivide((uint32_t) left, (uint32_t) right);
+            case '^':
+                return (int) WrappedPower((uint32_t) left, (uint32_t) right);
+            default:
+                return left * right;
+        }
+    }
+
+    // Nodes reachable from node, a negated variable counting as one like -x in a TreeNode
+    constexpr size_t SizeNode(int node) const {
+        const Node& n = _nodes[node];
+
+        if (n.op == 'n' || n.op == 'v' || n.op == '~') {
+            return 1;
+        }
+        return 1 + SizeNode(n.left) + SizeNode(n.right);
+    }
+
+    constexpr int EvaluateNode(int node, const int* values) const {
+        const Node& n = _nodes[node];
+
+        switch (n.op) {
+            case 'n':
+                return n.value;
+            case 'v':
+                return values[n.value];
+            case '~':
+                return -EvaluateNode(n.left, values);
+            default:
+                return Fold(n.op, EvaluateNode(n.left, values), EvaluateNode(n.right, values));
+        }
+    }
+
+    string PostfixNode(int node) const {
+        const Node& n = _nodes[node];
+
+        switch (n.op) {
+            case 'n':
+                return n.value < 0 ? "0 " + to_string(-n.value) + " -" : to_string(n.value);
+            case 'v':
+                return string(_text + n.left, n.right - n.left);
+            case '~':
+                return "0 " + PostfixNode(n.left) + " -";
+            default:
+                return PostfixNode(n.left) + " " + PostfixNode(n.right) + " " + n.op;
+        }
+    }
+
+    const char* _text;
+    Node _nodes[MaxTokens];
+    size_t _count;
+    int _root;
+    size_t _variables;
+    bool _valid;
+};
+
+#endif //STATICEXPRESSION_H
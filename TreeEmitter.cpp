@@ -0,0 +1,428 @@
+//
+// Implements the TreeEmitter Class
+// Author: Max Benson
+// Date: 11/29/2021
+//
+
+#include <unordered_map>
+#include <vector>
+#include "TreeEmitter.h"
+
+// Stands for "no child" in the value numbering of EmitLet
+static const size_t NoValue = (size_t) -1;
+
+// One pending step of an iterative traversal
+struct EmitFrame {
+    const TreeNode* node;
+    size_t state;       // how much of the node has been written, or parent id for DOT
+    bool fParen;
+};
+
+/**
+ * Write a tree in the requested format.  A null tree writes nothing.
+ * @param tree root of the tree
+ * @param format output format
+ */
+void TreeEmitter::Emit(const TreeNode* tree, OutputFormat format) {
+    if (tree == nullptr) {
+        return;
+    }
+    _fFirstToken = true;
+    switch (format) {
+        case InfixFormat:
+            EmitInfix(tree);
+            break;
+        case PostfixFormat:
+            EmitPostfix(tree);
+            break;
+        case PrefixFormat:
+            EmitPrefix(tree);
+            break;
+        case JsonFormat:
+            EmitJson(tree);
+            break;
+        case DotFormat:
+            EmitDot(tree);
+            break;
+        case LetFormat:
+            EmitLet(tree);
+            break;
+    }
+}
+
+/**
+ * Look up an output format by name
+ * @param name one of infix, postfix, prefix, json, dot, let
+ * @param format receives the format
+ * @return true if the name is known, false otherwise
+ */
+bool TreeEmitter::ParseFormat(const string& name, OutputFormat& format) {
+    if (name == "infix") {
+        format = InfixFormat;
+    } else if (name == "postfix") {
+        format = PostfixFormat;
+    } else if (name == "prefix") {
+        format = PrefixFormat;
+    } else if (name == "json") {
+        format = JsonFormat;
+    } else if (name == "dot") {
+        format = DotFormat;
+    } else if (name == "let") {
+        format = LetFormat;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Infix with every operator subtree except the outermost parenthesized,
+ * the same text ToString produces
+ */
+void TreeEmitter::EmitInfix(const TreeNode* tree) {
+    std::vector<EmitFrame> stack;
+
+    stack.push_back({tree, 0, false});
+    while (!stack.empty()) {
+        EmitFrame& frame = stack.back();
+        const TreeNode* node = frame.node;
+
+        if (node->Type() != Operator) {
+            _sink.Write(node->Data());
+            stack.pop_back();
+        } else if (frame.state == 0) {
+            if (frame.fParen) {
+                _sink.Put('(');
+            }
+            frame.state = 1;
+            stack.push_back({node->Left(), 0, true});
+        } else if (frame.state == 1) {
+            _sink.Write(node->Data());
+            frame.state = 2;
+            stack.push_back({node->Right(), 0, true});
+        } else {
+            if (frame.fParen) {
+                _sink.Put(')');
+            }
+            stack.pop_back();
+        }
+    }
+}
+
+/**
+ * Space separated postfix, suitable as input to BuildExpressionTree
+ */
+void TreeEmitter::EmitPostfix(const TreeNode* tree) {
+    std::vector<EmitFrame> stack;
+
+    stack.push_back({tree, 0, false});
+    while (!stack.empty()) {
+        EmitFrame& frame = stack.back();
+        const TreeNode* node = frame.node;
+
+        if (node->Type() != Operator) {
+            EmitLeafTokens(node, false);
+            stack.pop_back();
+        } else if (frame.state == 0) {
+            frame.state = 1;
+            stack.push_back({node->Left(), 0, false});
+        } else if (frame.state == 1) {
+            frame.state = 2;
+            stack.push_back({node->Right(), 0, false});
+        } else {
+            EmitToken(node->Data());
+            stack.pop_back();
+        }
+    }
+}
+
+/**
+ * Space separated prefix (Polish) notation
+ */
+void TreeEmitter::EmitPrefix(const TreeNode* tree) {
+    std::vector<const TreeNode*> stack;
+
+    stack.push_back(tree);
+    while (!stack.empty()) {
+        const TreeNode* node = stack.back();
+        stack.pop_back();
+
+        if (node->Type() != Operator) {
+            EmitLeafTokens(node, true);
+        } else {
+            EmitToken(node->Data());
+            stack.push_back(node->Right());
+            stack.push_back(node->Left());
+        }
+    }
+}
+
+/**
+ * Compact JSON.  Operators are {"op":"+","left":...,"right":...}, numbers
+ * are {"num":2} and variables are {"var":"x"}
+ */
+void TreeEmitter::EmitJson(const TreeNode* tree) {
+    std::vector<EmitFrame> stack;
+
+    stack.push_back({tree, 0, false});
+    while (!stack.empty()) {
+        EmitFrame& frame = stack.back();
+        const TreeNode* node = frame.node;
+
+        if (node->Type() != Operator) {
+            EmitJsonLeaf(node);
+            stack.pop_back();
+        } else if (frame.state == 0) {
+            _sink.Write("{\"op\":\"");
+            _sink.Write(node->Data());
+            _sink.Write("\",\"left\":");
+            frame.state = 1;
+            stack.push_back({node->Left(), 0, false});
+        } else if (frame.state == 1) {
+            _sink.Write(",\"right\":");
+            frame.state = 2;
+            stack.push_back({node->Right(), 0, false});
+        } else {
+            _sink.Put('}');
+            stack.pop_back();
+        }
+    }
+}
+
+/**
+ * Graphviz DOT digraph with one vertex per tree node, numbered in preorder
+ */
+void TreeEmitter::EmitDot(const TreeNode* tree) {
+    std::vector<EmitFrame> stack;
+    size_t nextId = 0;
+
+    _sink.Write("digraph Expression {\n");
+    stack.push_back({tree, 0, false});
+    while (!stack.empty()) {
+        EmitFrame frame = stack.back();
+        size_t id = nextId++;
+        stack.pop_back();
+
+        _sink.Write("  n");
+        _sink.WriteNumber(id);
+        _sink.Write(" [label=\"");
+        _sink.Write(frame.node->Data());
+        _sink.Write("\"];\n");
+        if (id > 0) {
+            _sink.Write("  n");
+            _sink.WriteNumber(frame.state);
+            _sink.Write(" -> n");
+            _sink.WriteNumber(id);
+            _sink.Write(";\n");
+        }
+        if (frame.node->Type() == Operator) {
+            stack.push_back({frame.node->Right(), id, false});
+            stack.push_back({frame.node->Left(), id, false});
+        }
+    }
+    _sink.Write("}\n");
+}
+
+/**
+ * Infix in which each operator subtree that occurs more than once is written
+ * once, as a binding, before the expression: t1 = x+y; t2 = t1*t1; t2-3.
+ * Subtrees are value numbered children first.  A node is looked up by its
+ * cached hash and confirmed by comparing its data and the numbers of its
+ * children, so equal copies match whether or not they share nodes.  A node
+ * shared by several parents is numbered once, so output size and time are
+ * linear in the number of distinct subtrees, however large the infix is.
+ * Binding names start with t, or with more t's if a variable could clash.
+ */
+void TreeEmitter::EmitLet(const TreeNode* tree) {
+    struct LetValue {
+        const TreeNode* node;
+        size_t left;
+        size_t right;
+        size_t uses;
+        size_t name;        // binding number, 0 if written in place
+    };
+    std::vector<LetValue> values;
+    std::unordered_map<const TreeNode*, size_t> valueOf;
+    std::unordered_map<uint64_t, std::vector<size_t> > valuesByHash;
+    std::vector<EmitFrame> stack;
+
+    stack.push_back({tree, 0, false});
+    while (!stack.empty()) {
+        EmitFrame& frame = stack.back();
+        const TreeNode* node = frame.node;
+
+        if (valueOf.find(node) != valueOf.end()) {
+            stack.pop_back();
+            continue;
+        }
+        if (node->Type() == Operator && frame.state == 0) {
+            frame.state = 1;
+            stack.push_back({node->Right(), 0, false});
+            stack.push_back({node->Left(), 0, false});
+            continue;
+        }
+
+        size_t left = node->Type() == Operator ? valueOf[node->Left()] : NoValue;
+        size_t right = node->Type() == Operator ? valueOf[node->Right()] : NoValue;
+        std::vector<size_t>& candidates = valuesByHash[node->Hash()];
+        size_t value = NoValue;
+        for (size_t i = 0; i < candidates.size() && value == NoValue; i ++) {
+            const LetValue& candidate = values[candidates[i]];
+            if (candidate.node->Type() == node->Type() && candidate.node->Data() == node->Data() &&
+                candidate.left == left && candidate.right == right) {
+                value = candidates[i];
+            }
+        }
+        if (value == NoValue) {
+            value = values.size();
+            values.push_back({node, left, right, 0, 0});
+            candidates.push_back(value);
+        }
+        valueOf[node] = value;
+        stack.pop_back();
+    }
+
+    // Bind every operator value used by more than one parent
+    std::vector<string> names;
+    for (size_t v = 0; v < values.size(); v ++) {
+        if (values[v].node->Type() == Operator) {
+            values[values[v].left].uses++;
+            values[values[v].right].uses++;
+        } else if (values[v].node->Type() == VariableOperand) {
+            names.push_back(values[v].node->Data()[0] == '-' ? values[v].node->Data().substr(1) : values[v].node->Data());
+        }
+    }
+
+    // Lengthen the prefix until no variable looks like prefix followed by digits,
+    // rechecking every name since a longer prefix can clash with one passed earlier
+    string prefix = "t";
+    bool fClash = true;
+    while (fClash) {
+        fClash = false;
+        for (size_t i = 0; i < names.size() && !fClash; i ++) {
+            const string& name = names[i];
+            fClash = name.length() > prefix.length() && name.compare(0, prefix.length(), prefix) == 0 &&
+                     name.find_first_not_of("0123456789", prefix.length()) == string::npos;
+        }
+        if (fClash) {
+            prefix += 't';
+        }
+    }
+    size_t root = valueOf[tree];
+    size_t bindings = 0;
+    for (size_t v = 0; v < values.size(); v ++) {
+        if (v != root && values[v].node->Type() == Operator && values[v].uses > 1) {
+            values[v].name = ++bindings;
+        }
+    }
+
+    // Infix over values, writing bound values other than the one being defined by name
+    std::vector<EmitFrame> body;
+    for (size_t v = 0; v < values.size(); v ++) {
+        if (v != root && values[v].name == 0) {
+            continue;
+        }
+        if (v != root) {
+            _sink.Write(prefix);
+            _sink.WriteNumber(values[v].name);
+            _sink.Write(" = ");
+        }
+        body.push_back({nullptr, 0, false});
+        std::vector<size_t> pending(1, v);
+        while (!pending.empty()) {
+            EmitFrame& frame = body.back();
+            const LetValue& value = values[pending.back()];
+
+            if (pending.back() != v && value.name != 0) {
+                _sink.Write(prefix);
+                _sink.WriteNumber(value.name);
+                body.pop_back();
+                pending.pop_back();
+            } else if (value.node->Type() != Operator) {
+                _sink.Write(value.node->Data());
+                body.pop_back();
+                pending.pop_back();
+            } else if (frame.state == 0) {
+                if (frame.fParen) {
+                    _sink.Put('(');
+                }
+                frame.state = 1;
+                body.push_back({nullptr, 0, true});
+                pending.push_back(value.left);
+            } else if (frame.state == 1) {
+                _sink.Write(value.node->Data());
+                frame.state = 2;
+                body.push_back({nullptr, 0, true});
+                pending.push_back(value.right);
+            } else {
+                if (frame.fParen) {
+                    _sink.Put(')');
+                }
+                body.pop_back();
+                pending.pop_back();
+            }
+        }
+        if (v != root) {
+            _sink.Write("; ");
+        }
+    }
+}
+
+/**
+ * Write a token, separated by a blank from the previous one
+ * @param token text of the token
+ */
+void TreeEmitter::EmitToken(const string& token) {
+    if (!_fFirstToken) {
+        _sink.Put(' ');
+    }
+    _sink.Write(token);
+    _fFirstToken = false;
+}
+
+/**
+ * Write the tokens for a leaf.  Simplification can produce negative numbers
+ * and negated variables such as -3 or -x, which are not valid tokens, so they
+ * are written as 0 - 3 or 0 - x.
+ * @param leaf number or variable node
+ * @param fPrefix true for prefix order, false for postfix order
+ */
+void TreeEmitter::EmitLeafTokens(const TreeNode* leaf, bool fPrefix) {
+    const string& data = leaf->Data();
+
+    if (data.length() > 1 && data[0] == '-') {
+        if (fPrefix) {
+            EmitToken("-");
+            EmitToken("0");
+            EmitToken(data.substr(1));
+        } else {
+            EmitToken("0");
+            EmitToken(data.substr(1));
+            EmitToken("-");
+        }
+    } else {
+        EmitToken(data);
+    }
+}
+
+/**
+ * Write a leaf as a JSON object, negated variables as a subtraction from 0
+ * @param leaf number or variable node
+ */
+void TreeEmitter::EmitJsonLeaf(const TreeNode* leaf) {
+    const string& data = leaf->Data();
+
+    if (leaf->Type() == NumberOperand) {
+        _sink.Write("{\"num\":");
+        _sink.Write(data);
+        _sink.Put('}');
+    } else if (data.length() > 1 && data[0] == '-') {
+        _sink.Write("{\"op\":\"-\",\"left\":{\"num\":0},\"right\":{\"var\":\"");
+        _sink.Write(data.data() + 1, data.length() - 1);
+        _sink.Write("\"}}");
+    } else {
+        _sink.Write("{\"var\":\"");
+        _sink.Write(data);
+        _sink.Write("\"}");
+    }
+}
@@ -0,0 +1,49 @@
+//
+// Interface Definition for the TreeEmitter Class
+// Author: Max Benson
+// Date: 11/29/2021
+//
+// Streams an expression tree into an OutputSink in one of several formats.
+// Trees are walked with an explicit stack, so arbitrarily deep trees can be
+// written without recursion and without building strings for subtrees.
+//
+#ifndef TREEEMITTER_H
+#define TREEEMITTER_H
+
+#include "OutputSink.h"
+#include "TreeNode.h"
+
+enum OutputFormat {
+    InfixFormat,        // same text as ExpressionTree's operator<<
+    PostfixFormat,      // accepted by BuildExpressionTree
+    PrefixFormat,
+    JsonFormat,         // compact JSON objects
+    DotFormat,          // Graphviz digraph
+    LetFormat           // infix with repeated subtrees bound to names once
+};
+
+class TreeEmitter {
+public:
+    TreeEmitter(OutputSink& sink) : _sink(sink), _fFirstToken(true) {};
+
+    void Emit(const TreeNode* tree, OutputFormat format);
+
+    static bool ParseFormat(const string& name, OutputFormat& format);
+
+private:
+    void EmitInfix(const TreeNode* tree);
+    void EmitPostfix(const TreeNode* tree);
+    void EmitPrefix(const TreeNode* tree);
+    void EmitJson(const TreeNode* tree);
+    void EmitDot(const TreeNode* tree);
+    void EmitLet(const TreeNode* tree);
+
+    void EmitToken(const string& token);
+    void EmitLeafTokens(const TreeNode* leaf, bool fPrefix);
+    void EmitJsonLeaf(const TreeNode* leaf);
+
+    OutputSink& _sink;
+    bool _fFirstToken;
+};
+
+#endif //TREEEMITTER_H
@@ -5,30 +5,310 @@
 //
 
 #include <assert.h>
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include "InternTable.h"
 #include "TreeNode.h"
 
+// Upper bound on the number of freed nodes each thread keeps for reuse
+static const size_t MaxPooledNodes = 65536;
+
+/**
+ * Per-thread free list of TreeNode sized blocks.  Keeping the pool per
+ * thread means long running workers stay warm without any locking.  A
+ * block freed on a different thread than the one that allocated it simply
+ * joins the freeing thread's list.
+ */
+struct NodePool {
+    struct Block {
+        Block* next;
+    };
+
+    Block* head = nullptr;
+    size_t count = 0;
+
+    ~NodePool() {
+        while (head != nullptr) {
+            Block* block = head;
+            head = head->next;
+            ::operator delete(block);
+        }
+    }
+};
+
+static thread_local NodePool nodePool;
+
+// Tags that keep the canonical hashes of different kinds of node apart
+static const uint64_t NumberTag = 0x2545F4914F6CDD1DULL;
+static const uint64_t VariableTag = 0x9E6C63D0676A9A99ULL;
+static const uint64_t SumTag = 0xD6E8FEB86659FD93ULL;
+static const uint64_t ProductTag = 0xA0761D6478BD642FULL;
+
+/**
+ * Mixes a value into a running hash
+ * @param seed hash so far
+ * @param value value to mix in
+ * @return new hash
+ */
+static uint64_t Mix(uint64_t seed, uint64_t value) {
+    uint64_t hash = (seed ^ value) * 0xBF58476D1CE4E5B9ULL;
+    return hash ^ (hash >> 29);
+}
+
 /**
  * Constructor
  * @param nodeType one of Operator, NumberOperand, or VariableOperand
- * @param data an operator (+, -, *), a number, or a variable name
+ * @param data an operator (+, -, *, /, ^), a number, or a variable name
  */
-TreeNode::TreeNode(NodeType nodeType, string data) {
+TreeNode::TreeNode(NodeType nodeType, string data) : _refCount(1) {
     _data=data;
+    _symbol = nodeType == VariableOperand ? SymbolTable::Current().Intern(data) : NoInternId;
     _left=nullptr;
     _right=nullptr;
     _nodeType=nodeType;
+    _variables = 0;
+    if (nodeType == VariableOperand) {
+        // Simplification writes 0 - x as the variable -x, which depends on x
+        uint32_t symbol = data.length() > 1 && data[0] == '-' ? SymbolTable::Current().Intern(data.substr(1)) : _symbol;
+        _variables = 1ULL << (symbol % 64);
+        // and which in a sum is the term x subtracted
+        _chainConstant = 0;
+        _chainHash = symbol == _symbol ? Mix(VariableTag, symbol) : 0 - Mix(VariableTag, symbol);
+    } else if (nodeType == NumberOperand) {
+        _chainConstant = (uint32_t) atoi(data.c_str());
+        _chainHash = 0;
+    }
+    UpdateMetadata();
+}
+
+/**
+ * Allocate storage for a node, reusing a previously freed block when possible
+ * @param size size of a TreeNode
+ * @return pointer to storage
+ */
+void* TreeNode::operator new(size_t size) {
+    assert(size == sizeof(TreeNode));
+    if (nodePool.head != nullptr) {
+        NodePool::Block* block = nodePool.head;
+        nodePool.head = block->next;
+        nodePool.count--;
+        return block;
+    }
+    return ::operator new(size);
+}
+
+/**
+ * Return storage of a destroyed node to this thread's free list
+ * @param node storage being freed
+ */
+void TreeNode::operator delete(void* node) {
+    if (node == nullptr) {
+        return;
+    }
+    if (nodePool.count >= MaxPooledNodes) {
+        ::operator delete(node);
+        return;
+    }
+    NodePool::Block* block = static_cast<NodePool::Block*>(node);
+    block->next = nodePool.head;
+    nodePool.head = block;
+    nodePool.count++;
 }
 
 /**
  * Destructor
- * Frees allocated memory
+ * Only called by Release, which has already detached the children
  */
 TreeNode::~TreeNode() {
-    if(_left!= nullptr){
-        delete _left;
+    assert(_left == nullptr && _right == nullptr);
+}
+
+/**
+ * Drop one reference to a node.  Nodes whose last reference goes away are
+ * freed along with any of their children that are no longer referenced.
+ * Works without recursion so that very deep trees can be freed.
+ * @param node node to release, may be nullptr
+ */
+void TreeNode::Release(TreeNode* node) {
+    // Kept across calls so that releasing a tree does not allocate
+    static thread_local std::vector<TreeNode*> pending;
+    size_t base = pending.size();
+
+    while (node != nullptr) {
+        TreeNode* next = nullptr;
+
+        if (node->_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            next = node->_left;
+            if (node->_right != nullptr) {
+                if (next == nullptr) {
+                    next = node->_right;
+                } else {
+                    pending.push_back(node->_right);
+                }
+            }
+            node->_left = nullptr;
+            node->_right = nullptr;
+            delete node;
+        }
+        if (next == nullptr && pending.size() > base) {
+            next = pending.back();
+            pending.pop_back();
+        }
+        node = next;
     }
-    if (_right!=nullptr) {
-        delete _right;
+}
+
+/**
+ * Make an unshared copy of this node that refers to the same children
+ * @return new node with one reference
+ */
+TreeNode* TreeNode::Clone() const {
+    TreeNode* copy = new TreeNode(_nodeType, _data);
+
+    if (_left != nullptr) {
+        copy->_left = _left->Retain();
+    }
+    if (_right != nullptr) {
+        copy->_right = _right->Retain();
+    }
+    copy->_variables = _variables;
+    copy->_hash = _hash;
+    copy->_size = _size;
+    copy->_depth = _depth;
+    copy->_canonicalHash = _canonicalHash;
+    copy->_chainConstant = _chainConstant;
+    copy->_chainHash = _chainHash;
+    return copy;
+}
+
+/**
+ * Replace the left child.  The node must not be shared.
+ * @param left new child, the caller's reference is taken over
+ */
+void TreeNode::SetLeft(TreeNode* left) {
+    assert(!IsShared());
+    Release(_left);
+    _left = left;
+    UpdateMetadata();
+}
+
+/**
+ * Replace the right child.  The node must not be shared.
+ * @param right new child, the caller's reference is taken over
+ */
+void TreeNode::SetRight(TreeNode* right) {
+    assert(!IsShared());
+    Release(_right);
+    _right = right;
+    UpdateMetadata();
+}
+
+/**
+ * Recompute the cached metadata from the node's own data and the metadata
+ * of its children
+ */
+void TreeNode::UpdateMetadata() {
+    if (_nodeType == Operator && (_left == nullptr || _right == nullptr)) {
+        // Still being built, the metadata is computed once both children are set
+        _variables = 0;
+        _size = 1;
+        _depth = 1;
+        _hash = 0;
+        _canonicalHash = 0;
+        _chainConstant = 0;
+        _chainHash = 0;
+        return;
+    }
+
+    uint64_t hash = _nodeType == VariableOperand ? _symbol : _nodeType == NumberOperand ? _chainConstant : (unsigned char) _data[0];
+
+    hash = (hash ^ (uint64_t) _nodeType) * 0x9E3779B97F4A7C15ULL;
+    _size = 1;
+    _depth = 1;
+    if (_nodeType == Operator) {
+        _variables = 0;
+    }
+    if (_left != nullptr) {
+        _variables |= _left->_variables;
+        _size += _left->_size;
+        _depth = 1 + _left->_depth;
+        hash = (hash ^ _left->_hash) * 0xBF58476D1CE4E5B9ULL;
+    }
+    if (_right != nullptr) {
+        _variables |= _right->_variables;
+        _size += _right->_size;
+        if (_depth < 1 + _right->_depth) {
+            _depth = 1 + _right->_depth;
+        }
+        hash = (hash + _right->_hash) * 0x94D049BB133111EBULL;
+    }
+    _hash = hash ^ (hash >> 31);
+
+    if (_nodeType == NumberOperand) {
+        _canonicalHash = Mix(NumberTag, _chainConstant);
+    } else if (_nodeType == VariableOperand) {
+        _canonicalHash = Mix(VariableTag, _symbol);
+    } else if (_data == "+" || _data == "-") {
+        uint32_t constant;
+        uint64_t terms;
+
+        _left->SumParts(_chainConstant, _chainHash);
+        _right->SumParts(constant, terms);
+        if (_data == "+") {
+            _chainConstant += constant;
+            _chainHash += terms;
+        } else {
+            _chainConstant -= constant;
+            _chainHash -= terms;
+        }
+        _canonicalHash = Mix(Mix(SumTag, _chainConstant), _chainHash);
+    } else if (_data == "*") {
+        uint32_t constant;
+        uint64_t factors;
+
+        _left->ProductParts(_chainConstant, _chainHash);
+        _right->ProductParts(constant, factors);
+        _chainConstant *= constant;
+        _chainHash += factors;
+        _canonicalHash = Mix(Mix(ProductTag, _chainConstant), _chainHash);
+    } else {
+        // Operands of other operators keep their order
+        _canonicalHash = Mix(Mix(Mix((unsigned char) _data[0], 0), _left->_canonicalHash), _right->_canonicalHash);
+        _chainConstant = 0;
+        _chainHash = _canonicalHash;
+    }
+}
+
+/**
+ * The contribution of this subtree to a chain of + and - it is a term of,
+ * matching how CanonicalNode flattens and folds the chain
+ * @param constant receives the number folded from the subtree
+ * @param terms receives the signed sum of the hashes of its other terms
+ */
+void TreeNode::SumParts(uint32_t& constant, uint64_t& terms) const {
+    if (_nodeType == Operator && _data == "*") {
+        constant = 0;
+        terms = _canonicalHash;
+    } else {
+        constant = _chainConstant;
+        terms = _chainHash;
+    }
+}
+
+/**
+ * The contribution of this subtree to a chain of * it is a factor of,
+ * matching how CanonicalNode flattens and folds the chain
+ * @param constant receives the product of the numbers in the subtree
+ * @param factors receives the sum of the hashes of its other factors
+ */
+void TreeNode::ProductParts(uint32_t& constant, uint64_t& factors) const {
+    if (_nodeType == NumberOperand || (_nodeType == Operator && _data == "*")) {
+        constant = _chainConstant;
+        factors = _chainHash;
+    } else {
+        constant = 1;
+        factors = _canonicalHash;
     }
 }
 
@@ -6,6 +6,8 @@
 #ifndef TREENODE_H
 #define TREENODE_H
 
+#include <stdint.h>
+#include <atomic>
 #include <iostream>
 using std::ostream;
 using std::string;
@@ -17,18 +19,58 @@ enum NodeType {
     VariableOperand
 };
 
+//
+// Nodes are reference counted so that trees can share subtrees.  A node
+// starts with one reference, owned by whoever created it.  A node referenced
+// more than once is shared and must be treated as immutable; Clone it to get
+// a private copy that can be changed.
+//
+// Each node also caches facts about the subtree below it: which variables
+// it uses, its size and depth, and a structural hash.  They are computed
+// when the node is created and whenever a child is set, so passes can look
+// them up in O(1) instead of walking the subtree.
+//
 class TreeNode {
 public:
     TreeNode(NodeType nodeType, string data);
-    ~TreeNode();
+
+    TreeNode(const TreeNode&) = delete;
+    const TreeNode& operator=(const TreeNode&) = delete;
+
+    TreeNode* Retain() { _refCount.fetch_add(1, std::memory_order_relaxed); return this; };
+    static void Release(TreeNode* node);
+    bool IsShared() const { return _refCount.load(std::memory_order_acquire) > 1; };
+    TreeNode* Clone() const;
+
+    // Nodes are recycled through a per-thread free list
+    static void* operator new(size_t size);
+    static void operator delete(void* node);
 
     NodeType Type() const { return _nodeType; };
-    string Data() const {return _data;};
+    const string& Data() const {return _data;};
+    uint32_t Symbol() const { return _symbol; };
     TreeNode *Left() const {return _left;};
     TreeNode *Right() const {return _right;};
 
-    void SetLeft(TreeNode* left) {_left = left;};
-    void SetRight(TreeNode* right) {_right = right;};
+    // Setters take over the caller's reference and release the old child
+    void SetLeft(TreeNode* left);
+    void SetRight(TreeNode* right);
+    TreeNode* TakeLeft() { TreeNode* left = _left; _left = nullptr; return left; };
+    TreeNode* TakeRight() { TreeNode* right = _right; _right = nullptr; return right; };
+
+    // Cached subtree metadata.  Bit (id % 64) of Variables() is set for the
+    // SymbolTable id of every variable in the subtree, -x counting as x, so
+    // subtrees with different bits cannot use the same variables.  Hash() is
+    // equal for structurally identical subtrees.  CanonicalHash() is equal
+    // for subtrees with the same CanonicalNode form, so a difference rules
+    // out IsSameTree without building the canonical forms.  After TakeLeft
+    // or TakeRight these are stale until the child is set again.
+    uint64_t Variables() const { return _variables; };
+    bool IsConstant() const { return _variables == 0; };
+    size_t Size() const { return _size; };
+    size_t Depth() const { return _depth; };
+    uint64_t Hash() const { return _hash; };
+    uint64_t CanonicalHash() const { return _canonicalHash; };
 
     bool IsNumber() const { return _nodeType == NumberOperand; };
     bool IsZero() const { return _nodeType == NumberOperand && _data == "0"; };
@@ -36,10 +78,29 @@ public:
     bool SplitNumTimesVariable(int& c, TreeNode** tree) const;
 
 private:
+    ~TreeNode();
+
+    void UpdateMetadata();
+    void SumParts(uint32_t& constant, uint64_t& terms) const;
+    void ProductParts(uint32_t& constant, uint64_t& factors) const;
+
+    std::atomic<size_t> _refCount;
     NodeType _nodeType;
     string _data;
+    uint32_t _symbol;       // SymbolTable id of a variable's name, NoInternId otherwise
     TreeNode* _left;
     TreeNode* _right;
+    uint64_t _variables;
+    uint64_t _hash;
+    size_t _size;
+    size_t _depth;
+    uint64_t _canonicalHash;
+    // For + and -, the folded number and the signed sum of the canonical
+    // hashes of the other terms of the flattened chain.  For *, the same
+    // with the product of the numbers.  For other nodes, the node as a term
+    // of a sum.
+    uint32_t _chainConstant;
+    uint64_t _chainHash;
 };
 
 #endif //TREENODE_H
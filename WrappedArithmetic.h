@@ -0,0 +1,69 @@
+//
+// Integer power and division with wrap around
+// Author: Max Benson
+// Date: 01/31/2022
+//
+// Values are 32 bit two's complement integers whose arithmetic wraps modulo
+// 2^32, as in ExpressionProgram.  These helpers define ^ and / the same way
+// for every place that computes them: constant folding in SimplifyNode,
+// ExpressionProgram, and StaticExpression.
+//
+//  - x ^ n for n >= 0 is computed by squaring, wrapping like repeated *.
+//    For n < 0 it is the truncated value of 1 / x^-n: 1 when x is 1, 1 or
+//    -1 when x is -1, and otherwise 0.
+//  - x / y truncates toward zero.  x / 0 is 0, and the one quotient that
+//    overflows, -2^31 / -1, wraps to -2^31.
+//
+// Simplification never folds x / 0 or 0 ^ n with n < 0, so those remain
+// visible in the simplified expression.
+//
+#ifndef WRAPPEDARITHMETIC_H
+#define WRAPPEDARITHMETIC_H
+
+#include <stdint.h>
+
+/**
+ * Integer power by repeated squaring
+ * @param base value raised to the power
+ * @param exponent power, as a signed 32 bit value
+ * @return base ^ exponent modulo 2^32
+ */
+constexpr uint32_t WrappedPower(uint32_t base, uint32_t exponent) {
+    if (exponent & 0x80000000u) {
+        if (base == 1) {
+            return 1;
+        }
+        if (base == 0xFFFFFFFFu) {
+            return (exponent & 1) ? 0xFFFFFFFFu : 1;
+        }
+        return 0;
+    }
+
+    uint32_t result = 1;
+    while (exponent != 0) {
+        if (exponent & 1) {
+            result *= base;
+        }
+        base *= base;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+/**
+ * Signed integer division truncating toward zero
+ * @param dividend value divided, as a signed 32 bit value
+ * @param divisor value divided by, as a signed 32 bit value
+ * @return dividend / divisor, 0 when divisor is 0
+ */
+constexpr uint32_t WrappedDivide(uint32_t dividend, uint32_t divisor) {
+    if (divisor == 0) {
+        return 0;
+    }
+    if (dividend == 0x80000000u && divisor == 0xFFFFFFFFu) {
+        return dividend;
+    }
+    return (uint32_t) ((int32_t) dividend / (int32_t) divisor);
+}
+
+#endif //WRAPPEDARITHMETIC_H
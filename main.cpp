@@ -1,13 +1,24 @@
 #include <iostream>
+#include <stdlib.h>
 using std::cin;
 using std::cout;
+using std::cerr;
 using std::endl;
 using std::string;
 using std::getline;
 
+#include "Benchmark.h"
+#include "CorpusDedup.h"
 #include "ExpressionTree.h"
+#include "Pipeline.h"
+#include "SimplifierServer.h"
 
-int main() {
+/**
+ * Read postfix lines from standard input, printing the infix and simplified
+ * form of each
+ * @return exit status
+ */
+int RunInteractive() {
     string postfix;
 
     cout << "> ";
@@ -30,3 +41,176 @@ int main() {
     return 0;
 }
 
+/**
+ * Read postfix lines from standard input and write each simplified
+ * expression on its own line in the requested format
+ * @param format output format
+ * @param fExpand whether to multiply out products after simplifying
+ * @param fHorner whether to rewrite polynomials in Horner form after simplifying
+ * @param fRebalance whether to rebalance + and * chains after simplifying
+ * @return exit status
+ */
+int RunFormatted(OutputFormat format, bool fExpand, bool fHorner, bool fRebalance) {
+    string postfix;
+    OutputSink sink(cout);
+
+    while ( getline(cin, postfix) ) {
+        if (postfix.length() > 0 && postfix[0] != '#') {
+            ExpressionTree expTree;
+
+            // Only the simplified form is written, so simplify while building
+            expTree.SetSimplifyOnBuild(true);
+            if (expTree.BuildExpressionTree(postfix)) {
+                if (fExpand) {
+                    expTree.Expand();
+                }
+                if (fHorner) {
+                    expTree.Horner();
+                }
+                if (fRebalance) {
+                    expTree.Rebalance();
+                }
+                expTree.Write(sink, format);
+                sink.Put('\n');
+            }
+            // Keep output in order with errors written by BuildExpressionTree
+            sink.Flush();
+        }
+    }
+    return 0;
+}
+
+/**
+ * Usage:
+ *   Simplifier                          interactive, reads postfix from standard input
+ *   Simplifier --format NAME            writes only the simplified expressions, formatted as
+ *                                       infix, postfix, prefix, json, dot, or let
+ *       --expand           multiply out products into a sum of terms in canonical order
+ *       --horner           rewrite polynomials in Horner form to save multiplications
+ *       --rebalance        regroup + and * chains into balanced trees after simplifying
+ *   Simplifier --pipeline [options]     same as --format, reading, tokenizing, simplifying,
+ *                                       and writing on separate threads, accepts the options above
+ *       --stats            write throughput and how busy each stage was to standard error
+ *   Simplifier --dedup [--confirm]     groups equivalent expressions read from standard input,
+ *                                       --confirm splits groups whose expanded forms differ
+ *                                       modulo 2^32
+ *   Simplifier --bench-rebalance N      times N evaluations of each expression read,
+ *                                       before and after rebalancing
+ *   Simplifier --bench-fused N          times N rows of evaluating all expressions read,
+ *                                       separately and as one fused program
+ *   Simplifier --bench-powers N         times N evaluations of each expression read,
+ *                                       as built and simplified into powers
+ *   Simplifier --bench-horner N         times N evaluations of each expression read,
+ *                                       before and after rewriting in Horner form
+ *   Simplifier --server PATH [options]  daemon listening on Unix domain socket PATH
+ *       --workers N        number of worker threads (default 4)
+ *       --max-request N    largest request frame accepted, in bytes
+ *       --max-depth N      deepest expression tree accepted
+ *       --idle-timeout N   seconds a connection may sit idle before it is closed
+ */
+int main(int argc, char* argv[]) {
+    string socketPath;
+    size_t workers = 4;
+    size_t maxRequest = 0;
+    size_t maxDepth = 0;
+    size_t idleTimeout = 0;
+    bool fFormat = false;
+    bool fExpand = false;
+    bool fHorner = false;
+    bool fRebalance = false;
+    bool fPipeline = false;
+    bool fStats = false;
+    size_t benchIterations = 0;
+    size_t fusedIterations = 0;
+    size_t powerIterations = 0;
+    size_t hornerIterations = 0;
+    bool fDedup = false;
+    bool fConfirm = false;
+    OutputFormat format = InfixFormat;
+
+    for (int i = 1; i < argc; i ++) {
+        string arg = argv[i];
+
+        if (arg == "--server" && i+1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--workers" && i+1 < argc) {
+            workers = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--max-request" && i+1 < argc) {
+            maxRequest = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--max-depth" && i+1 < argc) {
+            maxDepth = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--idle-timeout" && i+1 < argc) {
+            idleTimeout = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--dedup") {
+            fDedup = true;
+        } else if (arg == "--confirm") {
+            fConfirm = true;
+        } else if (arg == "--expand") {
+            fExpand = true;
+        } else if (arg == "--horner") {
+            fHorner = true;
+        } else if (arg == "--rebalance") {
+            fRebalance = true;
+        } else if (arg == "--pipeline") {
+            fPipeline = true;
+        } else if (arg == "--stats") {
+            fStats = true;
+        } else if (arg == "--bench-rebalance" && i+1 < argc) {
+            benchIterations = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--bench-fused" && i+1 < argc) {
+            fusedIterations = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--bench-powers" && i+1 < argc) {
+            powerIterations = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--bench-horner" && i+1 < argc) {
+            hornerIterations = strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--format" && i+1 < argc) {
+            if (!TreeEmitter::ParseFormat(argv[++i], format)) {
+                cerr << "Error: unknown format " << argv[i] << endl;
+                return 1;
+            }
+            fFormat = true;
+        } else {
+            cerr << "Error: unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (socketPath.length() > 0) {
+        SimplifierServer server(socketPath, workers);
+
+        if (maxRequest > 0) {
+            server.SetMaxRequestSize(maxRequest);
+        }
+        if (maxDepth > 0) {
+            server.SetMaxDepth(maxDepth);
+        }
+        if (idleTimeout > 0) {
+            server.SetIdleTimeout(idleTimeout);
+        }
+        return server.Run() ? 0 : 1;
+    }
+    if (fDedup) {
+        return RunCorpusDedup(cin, cout, fConfirm);
+    }
+    if (fusedIterations > 0) {
+        return RunFusedBenchmark(cin, cout, fusedIterations);
+    }
+    if (hornerIterations > 0) {
+        return RunHornerBenchmark(cin, cout, hornerIterations);
+    }
+    if (powerIterations > 0) {
+        return RunPowerBenchmark(cin, cout, powerIterations);
+    }
+    if (benchIterations > 0) {
+        return RunRebalanceBenchmark(cin, cout, benchIterations);
+    }
+    if (fPipeline) {
+        // Let the reader see how much input is buffered, to send partial batches on
+        std::ios::sync_with_stdio(false);
+        return RunPipeline(cin, cout, format, fExpand, fHorner, fRebalance, fStats);
+    }
+    if (fFormat || fExpand || fHorner || fRebalance) {
+        return RunFormatted(format, fExpand, fHorner, fRebalance);
+    }
+    return RunInteractive();
+}
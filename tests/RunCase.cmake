@@ -0,0 +1,16 @@
+#
+# Runs SIMPLIFIER with the arguments in ARGS on the file INPUT and checks
+# that its standard output matches the file EXPECTED
+#
+separate_arguments(ARGS)
+execute_process(COMMAND ${SIMPLIFIER} ${ARGS}
+                INPUT_FILE ${INPUT}
+                OUTPUT_VARIABLE output
+                RESULT_VARIABLE result)
+file(READ ${EXPECTED} expected)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "Simplifier ${ARGS} exited with ${result}")
+endif ()
+if (NOT output STREQUAL expected)
+    message(FATAL_ERROR "Simplifier ${ARGS} wrote\n${output}\nexpected\n${expected}")
+endif ()
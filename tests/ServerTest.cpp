@@ -0,0 +1,179 @@
+//
+// Tests of SimplifierServer
+// Author: Max Benson
+// Date: 11/15/2021
+//
+// Runs a server in this process on a socket in /tmp and talks to it over
+// the wire format described in SimplifierServer.h.  Exits with 1 after
+// reporting every check that failed.
+//
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+using std::cerr;
+using std::endl;
+using std::string;
+using std::to_string;
+
+#include "SimplifierServer.h"
+
+static int failures = 0;
+
+/**
+ * Report a failed check
+ * @param fPassed result of the check
+ * @param what description of the check
+ */
+static void Check(bool fPassed, const string& what) {
+    if (!fPassed) {
+        cerr << "FAILED: " << what << endl;
+        failures ++;
+    }
+}
+
+/**
+ * Give up on reads from the server after five seconds, so a check that
+ * fails does not hang the test
+ */
+static void SetReadTimeout(int fd) {
+    struct timeval timeout = { 5, 0 };
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+/**
+ * Connect to the server, waiting up to five seconds for it to start listening
+ * @param path socket path
+ * @return connected socket, or -1
+ */
+static int Connect(const string& path) {
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    for (int attempt = 0; attempt < 500; attempt ++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0) {
+            SetReadTimeout(fd);
+            return fd;
+        }
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+/**
+ * Send a payload preceded by its 4 byte big-endian length
+ * @return true if the frame was sent
+ */
+static bool SendFrame(int fd, const string& payload) {
+    uint32_t length = payload.length();
+    string frame;
+
+    frame += (char) ((length >> 24) & 0xFF);
+    frame += (char) ((length >> 16) & 0xFF);
+    frame += (char) ((length >> 8) & 0xFF);
+    frame += (char) (length & 0xFF);
+    frame += payload;
+    return send(fd, frame.data(), frame.length(), MSG_NOSIGNAL) == (ssize_t) frame.length();
+}
+
+/**
+ * Read exactly length bytes
+ * @return true if all bytes were read
+ */
+static bool Receive(int fd, char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t count = read(fd, buffer, length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        buffer += count;
+        length -= count;
+    }
+    return true;
+}
+
+/**
+ * Read one response frame
+ * @param payload receives the frame without its length
+ * @return true if a whole frame was read
+ */
+static bool ReadFrame(int fd, string& payload) {
+    unsigned char header[4];
+
+    if (!Receive(fd, (char*) header, sizeof(header))) {
+        return false;
+    }
+    payload.resize(((size_t) header[0] << 24) | ((size_t) header[1] << 16) | ((size_t) header[2] << 8) | header[3]);
+    return payload.empty() || Receive(fd, &payload[0], payload.length());
+}
+
+int main() {
+    string path = "/tmp/SimplifierServerTest." + to_string(getpid());
+    string reply;
+
+    // Run never returns while the server is up, so the server outlives main
+    SimplifierServer* server = new SimplifierServer(path, 2);
+    server->SetMaxRequestSize(64);
+    server->SetIdleTimeout(1);
+    std::thread([server] { server->Run(); }).detach();
+
+    int fd = Connect(path);
+    Check(fd >= 0, "connect to " + path);
+    if (fd < 0) {
+        return 1;
+    }
+
+    // A request over the limit is answered, and the connection stays usable
+    Check(SendFrame(fd, string(100000, ' ')), "send oversized request");
+    Check(ReadFrame(fd, reply), "read reply to oversized request");
+    Check(reply == "ERR request too large\n", "oversized request answered with ERR, got " + reply);
+    Check(SendFrame(fd, "x 0 +\n1 2 +"), "send request after oversized one");
+    Check(ReadFrame(fd, reply), "read reply to request after oversized one");
+    Check(reply == "OK x+0\tx\nOK 1+2\t3\n", "request after oversized one answered, got " + reply);
+
+    // Names interned for one batch are forgotten before the next
+    Check(SendFrame(fd, "b a * a b * -\nc d + c -"), "send request with new names");
+    Check(ReadFrame(fd, reply), "read reply to request with new names");
+    Check(reply == "OK (b*a)-(a*b)\t0\nOK (c+d)-c\t(c+d)-c\n", "request with new names answered, got " + reply);
+
+    close(fd);
+
+    // Idle clients holding both workers are dropped, so a third is served
+    int idle[2] = { Connect(path), Connect(path) };
+    fd = Connect(path);
+    Check(idle[0] >= 0 && idle[1] >= 0 && fd >= 0, "connect three clients");
+    if (fd >= 0) {
+        Check(SendFrame(fd, "x x *"), "send request behind idle clients");
+        Check(ReadFrame(fd, reply), "read reply to request behind idle clients");
+        Check(reply == "OK x*x\tx^2\n", "request behind idle clients answered, got " + reply);
+        close(fd);
+    }
+    for (int i = 0; i < 2; i ++) {
+        char byte;
+        Check(idle[i] < 0 || read(idle[i], &byte, 1) == 0, "idle client disconnected");
+        close(idle[i]);
+    }
+
+    unlink(path.c_str());
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,97 @@
+//
+// Build time checks of StaticExpression.h
+// Author: Max Benson
+// Date: 02/09/2022
+//
+// Compiled with the Simplifier but never run: every check is a
+// static_assert, so the build fails if the compile time simplifier stops
+// agreeing with SimplifyTree on the examples in README.md.
+//
+
+#include <type_traits>
+#include "Polynomial.h"
+#include "StaticExpression.h"
+
+static_assert(StaticMaxDegree == Polynomial::MaxDegree, "powers are combined up to the same degree");
+
+//
+// Expression templates
+//
+
+namespace {
+StaticVar<0> x;
+StaticVar<1> y;
+}
+
+// The examples in the header and README.md
+static_assert(std::is_same<StaticSimplified<decltype((x + StaticNum<0>()) * (y - y))>, StaticNum<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x * StaticNum<2>())>, StaticMul<StaticVar<0>, StaticNum<2> > >::value, "");
+
+// Simple arithmetic, multiplication by 0, adding or subtracting 0
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<2>() + StaticNum<3>())>, StaticNum<5> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<2>() - StaticNum<3>())>, StaticNum<-1> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<0>() * (x + y))>, StaticNum<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<0>() + x)>, StaticVar<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x - StaticNum<0>())>, StaticVar<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<0>() - x)>, StaticNeg<StaticVar<0> > >::value, "");
+
+// Subtraction of equal quantities, with operands of + and * in either order
+static_assert(std::is_same<StaticSimplified<decltype((x + y) - (y + x))>, StaticNum<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x * y - y * x)>, StaticNum<0> >::value, "");
+
+// Division and powers; x / 0 is left as written
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<7>() / StaticNum<2>())>, StaticNum<3> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x / StaticNum<0>())>, StaticDiv<StaticVar<0>, StaticNum<0> > >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<0>() / x)>, StaticNum<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(StaticNum<0>() / StaticNum<0>())>, StaticNum<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x / StaticNum<1>())>, StaticVar<0> >::value, "");
+static_assert(std::is_same<StaticSimplified<StaticPow<StaticNum<2>, StaticNum<10> > >, StaticNum<1024> >::value, "");
+static_assert(std::is_same<StaticSimplified<StaticPow<StaticVar<0>, StaticNum<0> > >, StaticNum<1> >::value, "");
+static_assert(std::is_same<StaticSimplified<StaticPow<StaticNum<1>, StaticVar<0> > >, StaticNum<1> >::value, "");
+static_assert(std::is_same<StaticSimplified<StaticPow<StaticNum<1>, StaticNum<0> > >, StaticNum<1> >::value, "");
+static_assert(std::is_same<StaticSimplified<decltype(x * x)>, StaticPow<StaticVar<0>, StaticNum<2> > >::value, "");
+
+//
+// Constexpr postfix
+//
+
+constexpr int Values[] = {2, 3, 5};
+
+// The example in the header and README.md, 2 * (2+3)
+constexpr StaticPostfix<16> Example("x 2 3 + *");
+static_assert(Example.IsValid() && Example.Size() == 3 && Example.Evaluate(Values) == 10, "");
+
+// Repeated factors combine into one power, x^4
+constexpr StaticPostfix<16> Powers("x x * x * x *");
+static_assert(Powers.Size() == 3 && Powers.Evaluate(Values) == 16, "");
+constexpr StaticPostfix<16> PowerProduct("x 2 ^ x 3 ^ *");
+static_assert(PowerProduct.Size() == 3 && PowerProduct.Evaluate(Values) == 32, "");
+constexpr StaticPostfix<16> PowerChain("x y * x *");
+static_assert(PowerChain.Size() == 5 && PowerChain.Evaluate(Values) == 12, "");
+constexpr StaticPostfix<16> PowerOfPower("x 2 ^ 3 ^");
+static_assert(PowerOfPower.Size() == 3 && PowerOfPower.Evaluate(Values) == 64, "");
+constexpr StaticPostfix<5> PowerOfPowerNoRoom("x 2 ^ 3 ^");
+static_assert(PowerOfPowerNoRoom.Size() == 5 && PowerOfPowerNoRoom.Evaluate(Values) == 64, "");
+constexpr StaticPostfix<16> PowerTooLarge("x 256 ^ 257 ^");
+static_assert(PowerTooLarge.Size() == 5, "");
+
+// x / 0 and 0 ^ n with n < 0 are left as written; 0 / exp and 1 ^ exp fold
+constexpr StaticPostfix<16> DivideByZero("x 0 /");
+static_assert(DivideByZero.Size() == 3 && DivideByZero.Evaluate(Values) == 0, "");
+constexpr StaticPostfix<16> ZeroToNegative("0 0 1 - ^");
+static_assert(ZeroToNegative.Size() == 3, "");
+constexpr StaticPostfix<16> ZeroDivided("0 x y + /");
+static_assert(ZeroDivided.IsNumber() && ZeroDivided.Evaluate(Values) == 0, "");
+constexpr StaticPostfix<16> OneRaised("1 x y + ^");
+static_assert(OneRaised.IsNumber() && OneRaised.Evaluate(Values) == 1, "");
+
+// Subtraction of equal quantities, and the case where the two differ:
+// SimplifyTree regroups chains, so (x+y)+z - (x+(y+z)) is 0 there
+constexpr StaticPostfix<16> Same("x y + y x + -");
+static_assert(Same.IsNumber() && Same.Evaluate(Values) == 0, "");
+constexpr StaticPostfix<16> Regrouped("x y + z + x y z + + -");
+static_assert(!Regrouped.IsNumber() && Regrouped.Evaluate(Values) == 0, "");
+
+// Invalid postfix
+static_assert(!StaticPostfix<16>("x +").IsValid(), "");
+static_assert(!StaticPostfix<16>("x y").IsValid(), "");